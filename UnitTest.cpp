@@ -7,7 +7,41 @@
 
 #include <UnitTest++/UnitTest++.h>
 #include "interface.h"
+#include "cache.h"
+#include "capture.h"
+#include "codec.h"
+#include "connection.h"
+#include "crypto.h"
+#include "handoff.h"
+#include "reactor.h"
+#include "reduce.h"
+#include "shm.h"
+#include "supervisor.h"
+#include "threadpool.h"
+#include "tls.h"
+#include "trace.h"
+#include "userbase.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <poll.h>
+#include <random>
+#include <set>
 #include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 /**
  * @brief Тесты для проверки вывода справки
@@ -237,6 +271,89 @@ SUITE(OptionalParametersTest) {
         CHECK(iface.Parser(argc, argv));
         CHECK_EQUAL("journal.txt", iface.getParams().logFile);
     }
+
+    /**
+     * @brief Тест параметров плавной остановки
+     * @details Проверяет значения по умолчанию для --idle-timeout, --drain-timeout и --handoff
+     */
+    TEST(DefaultShutdownParameters) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL(60, iface.getParams().idleTimeout);
+        CHECK_EQUAL(30, iface.getParams().drainTimeout);
+        CHECK_EQUAL("", iface.getParams().handoffPath);
+    }
+
+    /**
+     * @brief Тест параметров горячего обновления
+     * @details Проверяет корректный разбор --drain-timeout и --handoff
+     */
+    TEST(HandoffParameters) {
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--drain-timeout", "5", "--handoff", "/run/server.sock", nullptr};
+        int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+        CHECK(iface.Parser(argc, argv));
+        CHECK_EQUAL(5, iface.getParams().drainTimeout);
+        CHECK_EQUAL("/run/server.sock", iface.getParams().handoffPath);
+    }
+
+    /**
+     * @brief Тест параметров больших векторов
+     * @details Проверяет значения по умолчанию и разбор --max-vector, --parallel-threshold, --reduce-threads
+     */
+    TEST(LargeVectorParameters) {
+        UserInterface defaults;
+        const char* argv1[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
+        CHECK(defaults.Parser(sizeof(argv1) / sizeof(argv1[0]) - 1, argv1));
+        CHECK_EQUAL(10000u, defaults.getParams().maxVectorSize);
+        CHECK_EQUAL(0, defaults.getParams().reduceThreads);
+
+        UserInterface iface;
+        const char* argv2[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--max-vector", "8000000",
+                               "--parallel-threshold", "100000", "--reduce-threads", "4", nullptr};
+        CHECK(iface.Parser(sizeof(argv2) / sizeof(argv2[0]) - 1, argv2));
+        CHECK_EQUAL(8000000u, iface.getParams().maxVectorSize);
+        CHECK_EQUAL(100000u, iface.getParams().parallelThreshold);
+        CHECK_EQUAL(4, iface.getParams().reduceThreads);
+    }
+
+    /**
+     * @brief Тест режима обработки сессий
+     * @details Проверяет значение по умолчанию, режим сопрограмм и отказ от неизвестного режима
+     */
+    TEST(SessionModeParameters) {
+        UserInterface defaults;
+        const char* argv1[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
+        CHECK(defaults.Parser(sizeof(argv1) / sizeof(argv1[0]) - 1, argv1));
+        CHECK_EQUAL("threads", defaults.getParams().sessionMode);
+
+        UserInterface iface;
+        const char* argv2[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--mode", "coro", nullptr};
+        CHECK(iface.Parser(sizeof(argv2) / sizeof(argv2[0]) - 1, argv2));
+        CHECK_EQUAL("coro", iface.getParams().sessionMode);
+
+        UserInterface invalid;
+        const char* argv3[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--mode", "fibers", nullptr};
+        CHECK_THROW(invalid.Parser(sizeof(argv3) / sizeof(argv3[0]) - 1, argv3), po::validation_error);
+    }
+
+    /**
+     * @brief Тест профиля низкой задержки
+     * @details Проверяет, что профиль выключен по умолчанию и включается --low-latency
+     */
+    TEST(LowLatencyParameter) {
+        UserInterface defaults;
+        const char* argv1[] = {"test", "-b", "db", "-j", "log", "-p", "9090", nullptr};
+        CHECK(defaults.Parser(sizeof(argv1) / sizeof(argv1[0]) - 1, argv1));
+        CHECK(!defaults.getParams().lowLatency);
+
+        UserInterface iface;
+        const char* argv2[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "--low-latency", nullptr};
+        CHECK(iface.Parser(sizeof(argv2) / sizeof(argv2[0]) - 1, argv2));
+        CHECK(iface.getParams().lowLatency);
+    }
 }
 
 /**
@@ -361,6 +478,1645 @@ SUITE(SpecialValuesTest) {
         CHECK(iface.Parser(argc, argv));
         CHECK_EQUAL("::1", iface.getParams().Address);
     }
+
+    /**
+     * @brief Тест определения семейства адресов
+     * @details Проверяет, что IPv4, IPv6 и Unix-адреса распознаются по синтаксису --address
+     */
+    TEST(AddressFamilies) {
+        struct {
+            const char* address;
+            int family;
+        } cases[] = {
+            {"127.0.0.1", AF_INET},
+            {"::1", AF_INET6},
+            {"[::]", AF_INET6},
+            {"unix:/tmp/server.sock", AF_UNIX},
+            {"@server", AF_UNIX},
+        };
+        for (const auto& c : cases) {
+            UserInterface iface;
+            const char* argv[] = {"test", "-b", "db", "-j", "log", "-p", "9090", "-a", c.address, nullptr};
+            int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+            CHECK(iface.Parser(argc, argv));
+            CHECK_EQUAL(c.family, iface.getParams().addressFamily);
+        }
+    }
+
+    /**
+     * @brief Тест пути Unix-сокета
+     * @details Проверяет выделение пути файла сокета и абстрактного имени из адреса
+     */
+    TEST(UnixSocketPath) {
+        CHECK_EQUAL("/tmp/server.sock", unixSocketPath("unix:/tmp/server.sock"));
+        CHECK_EQUAL("@server", unixSocketPath("unix:@server"));
+        CHECK_EQUAL("@server", unixSocketPath("@server"));
+        CHECK_EQUAL("", unixSocketPath("10.0.0.1"));
+    }
+}
+
+/**
+ * @brief Тесты ядер свертки векторов
+ * @details Проверяет результаты специализированных ядер для разных операций, типов и политик переполнения
+ */
+SUITE(ReduceTest) {
+    /**
+     * @brief Тест насыщающего произведения uint16_t (исходный протокол)
+     * @details Проверяет обычное произведение, насыщение до UINT32_MAX и пустой вектор
+     */
+    TEST(SaturatingProductU16) {
+        const ReduceKernel& kernel = selectKernel(ReduceOp::Product, ElemType::U16, OverflowPolicy::Saturate);
+        ReduceResult result;
+        uint32_t value;
+
+        std::vector<uint16_t> small = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+        CHECK(!reduceBlock(kernel, small.data(), small.size(), result));
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(362880u, value);
+        CHECK_EQUAL(sizeof(uint32_t), result.size);
+
+        std::vector<uint16_t> big(12, 65535);
+        CHECK(reduceBlock(kernel, big.data(), big.size(), result));
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(UINT32_MAX, value);
+
+        CHECK(!reduceBlock(kernel, nullptr, 0, result));
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(1u, value);
+    }
+
+    /**
+     * @brief Тест суммы int32_t с переносом и насыщением
+     * @details Проверяет, что политика переполнения меняет только поведение на границе типа
+     */
+    TEST(SumI32Policies) {
+        std::vector<int32_t> data = {INT32_MAX, 1, 2};
+        ReduceResult result;
+        int32_t value;
+
+        CHECK(reduceBlock(selectKernel(ReduceOp::Sum, ElemType::I32, OverflowPolicy::Wrap), data.data(), data.size(), result));
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(INT32_MIN + 2, value);
+
+        CHECK(reduceBlock(selectKernel(ReduceOp::Sum, ElemType::I32, OverflowPolicy::Saturate), data.data(), data.size(), result));
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(INT32_MAX, value);
+    }
+
+    /**
+     * @brief Тест минимума, максимума и среднего
+     * @details Проверяет операции без переполнения на векторе длиннее ширины внутреннего цикла
+     */
+    TEST(MinMaxMean) {
+        std::vector<double> data;
+        for (int i = 1; i <= 21; ++i) {
+            data.push_back(i);
+        }
+        ReduceResult result;
+        double value;
+
+        reduceBlock(selectKernel(ReduceOp::Min, ElemType::F64, OverflowPolicy::Saturate), data.data(), data.size(), result);
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(1.0, value);
+
+        reduceBlock(selectKernel(ReduceOp::Max, ElemType::F64, OverflowPolicy::Saturate), data.data(), data.size(), result);
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(21.0, value);
+
+        reduceBlock(selectKernel(ReduceOp::Mean, ElemType::F64, OverflowPolicy::Saturate), data.data(), data.size(), result);
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(11.0, value);
+    }
+
+    /**
+     * @brief Тест выбора ядра по именам из рукопожатия
+     * @details Проверяет распознавание допустимых имен и отказ для неизвестных
+     */
+    TEST(SelectByName) {
+        const ReduceKernel* kernel = selectKernel("max", "uint64", "wrap");
+        CHECK(kernel != nullptr);
+        CHECK(kernel->op == ReduceOp::Max);
+        CHECK(kernel->type == ElemType::U64);
+        CHECK_EQUAL(sizeof(uint64_t), kernel->elemSize);
+        CHECK(selectKernel("median", "uint16", "saturate") == nullptr);
+        CHECK(selectKernel("sum", "int8", "saturate") == nullptr);
+    }
+
+    /**
+     * @brief Тест параллельной свертки
+     * @details Проверяет, что разбиение вектора на части дает тот же результат,
+     * что и последовательная свертка, в том числе при насыщении в одной из частей
+     */
+    TEST(ParallelMatchesSerial) {
+        ThreadPool pool(3);
+        const ReduceKernel& product = selectKernel(ReduceOp::Product, ElemType::U16, OverflowPolicy::Saturate);
+        const ReduceKernel& sum = selectKernel(ReduceOp::Sum, ElemType::U64, OverflowPolicy::Wrap);
+        ReduceResult serial, parallel;
+
+        std::vector<uint16_t> ones(100003, 1);
+        ones[7] = 3;
+        ones[99999] = 5;
+        CHECK_EQUAL(reduceBlock(product, ones.data(), ones.size(), serial),
+                    reduceParallel(product, ones.data(), ones.size(), pool, parallel));
+        CHECK(std::memcmp(serial.bytes, parallel.bytes, serial.size) == 0);
+
+        ones[50000] = 65535;
+        ones[50001] = 65535;
+        ones[50002] = 65535;
+        CHECK(reduceParallel(product, ones.data(), ones.size(), pool, parallel));
+        uint32_t value;
+        std::memcpy(&value, parallel.bytes, sizeof(value));
+        CHECK_EQUAL(UINT32_MAX, value);
+
+        std::vector<uint64_t> values(77777);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = i * 0x9E3779B97F4A7C15ull;
+        }
+        reduceBlock(sum, values.data(), values.size(), serial);
+        reduceParallel(sum, values.data(), values.size(), pool, parallel);
+        CHECK(std::memcmp(serial.bytes, parallel.bytes, serial.size) == 0);
+    }
+
+    /**
+     * @brief Тест насыщения знаковых значений разных знаков
+     * @details Насыщение int32_t не ассоциативно, поэтому результат должен
+     * совпадать с последовательной сверткой по порядку элементов независимо
+     * от внутренних аккумуляторов, разбиения на блоки и пула потоков
+     */
+    TEST(SignedSaturationIsOrdered) {
+        const ReduceKernel& sum = selectKernel(ReduceOp::Sum, ElemType::I32, OverflowPolicy::Saturate);
+        const ReduceKernel& product = selectKernel(ReduceOp::Product, ElemType::I32, OverflowPolicy::Saturate);
+        ReduceResult result;
+        int32_t value;
+
+        std::vector<int32_t> small = {INT32_MAX, 1, -1};
+        reduceBlock(sum, small.data(), small.size(), result);
+        std::memcpy(&value, result.bytes, sizeof(value));
+        CHECK_EQUAL(INT32_MAX - 1, value);
+
+        // Период 4 при 8 аккумуляторах собирает одинаковые знаки в одном аккумуляторе
+        std::vector<int32_t> mixed(100003);
+        for (size_t i = 0; i < mixed.size(); ++i) {
+            mixed[i] = (i % 4 < 2 ? INT32_MAX : -INT32_MAX) / static_cast<int32_t>(1 + i % 3);
+        }
+        mixed[100002] = 2;
+        ThreadPool pool(3);
+        for (const ReduceKernel* kernel : {&sum, &product}) {
+            int64_t expected = kernel->op == ReduceOp::Sum ? 0 : 1;
+            for (int32_t elem : mixed) {
+                int64_t next = kernel->op == ReduceOp::Sum ? expected + elem : expected * elem;
+                expected = std::min<int64_t>(std::max<int64_t>(next, INT32_MIN), INT32_MAX);
+            }
+
+            CHECK(!kernel->splittable);
+            reduceBlock(*kernel, mixed.data(), mixed.size(), result);
+            std::memcpy(&value, result.bytes, sizeof(value));
+            CHECK_EQUAL(expected, value);
+
+            reduceParallel(*kernel, mixed.data(), mixed.size(), pool, result);
+            std::memcpy(&value, result.bytes, sizeof(value));
+            CHECK_EQUAL(expected, value);
+
+            ReduceState state;
+            kernel->init(state);
+            for (size_t i = 0; i < mixed.size(); i += 7) {
+                kernel->feed(state, mixed.data() + i, std::min<size_t>(7, mixed.size() - i));
+            }
+            kernel->finish(state, result.bytes);
+            std::memcpy(&value, result.bytes, sizeof(value));
+            CHECK_EQUAL(expected, value);
+        }
+        CHECK(selectKernel(ReduceOp::Sum, ElemType::I32, OverflowPolicy::Wrap).splittable);
+        CHECK(selectKernel(ReduceOp::Sum, ElemType::U64, OverflowPolicy::Saturate).splittable);
+    }
+}
+
+/**
+ * @brief Тесты кэша результатов
+ * @details Проверяет потоковые хеши, проверку ключа и вытеснение записей LRU-кэша
+ */
+SUITE(CacheTest) {
+    /**
+     * @brief Тест потокового хеша
+     * @details Проверяет эталонное значение MurmurHash3 x64-128 и независимость
+     * результата от разбиения данных на части
+     */
+    TEST(StreamingHash) {
+        const std::string text = "The quick brown fox jumps over the lazy dog";
+        Hasher128 whole;
+        whole.update(text.data(), text.size());
+        Hash128 expected = whole.digest();
+        CHECK_EQUAL(0xe34bbc7bbc071b6cull, expected.lo);
+        CHECK_EQUAL(0x7a433ca9c49a9347ull, expected.hi);
+
+        for (size_t cut = 0; cut <= text.size(); cut += 7) {
+            Hasher128 parts;
+            parts.update(text.data(), cut);
+            parts.update(text.data() + cut, text.size() - cut);
+            CHECK(parts.digest() == expected);
+        }
+    }
+
+    /**
+     * @brief Тест потокового SipHash
+     * @details Проверяет эталонное значение SipHash-2-4 из описания алгоритма
+     * (ключ 00..0f, сообщение 00..0e) и независимость от разбиения данных
+     */
+    TEST(StreamingSipHash) {
+        unsigned char message[15];
+        for (size_t i = 0; i < sizeof(message); ++i) {
+            message[i] = static_cast<unsigned char>(i);
+        }
+        for (size_t cut = 0; cut <= sizeof(message); ++cut) {
+            SipHasher hasher(0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull);
+            hasher.update(message, cut);
+            hasher.update(message + cut, sizeof(message) - cut);
+            CHECK_EQUAL(0xa129ca6149be45e5ull, hasher.digest());
+        }
+    }
+
+    /**
+     * @brief Тест подложенной записи
+     * @details Запись с тем же MurmurHash3, но другим проверочным хешем или
+     * длиной не выдается; ключи одного варианта и данных совпадают, а разных
+     * вариантов - нет
+     */
+    TEST(ForgedEntryIsMiss) {
+        ResultCache cache(1 << 20);
+        CachedResult value{{{7, 0, 0, 0, 0, 0, 0, 0}, 4}, false};
+        CachedResult found;
+
+        CacheKey planted{{1, 0}, 42, 8};
+        cache.insert(planted, value);
+        CHECK(!cache.find(CacheKey{{1, 0}, 43, 8}, found));
+        CHECK(!cache.find(CacheKey{{1, 0}, 42, 16}, found));
+        CHECK(cache.find(planted, found));
+
+        const char data[] = "vector";
+        CacheKeyHasher a(1), b(1), c(2);
+        a.update(data, sizeof(data));
+        b.update(data, 3);
+        b.update(data + 3, sizeof(data) - 3);
+        c.update(data, sizeof(data));
+        CHECK(a.key() == b.key());
+        CHECK(!(a.key().hash == c.key().hash));
+        CHECK(a.key().check != c.key().check);
+        CHECK_EQUAL(sizeof(data), a.key().length);
+    }
+
+    /**
+     * @brief Тест вытеснения и счетчиков
+     * @details Проверяет, что при исчерпании бюджета вытесняется самая старая
+     * запись сегмента, а попадания и промахи учитываются
+     */
+    TEST(LruEviction) {
+        ResultCache cache(1); // одна запись на сегмент
+        CachedResult value{{{7, 0, 0, 0, 0, 0, 0, 0}, 4}, false};
+        CachedResult found;
+
+        CacheKey first{{1, 0}, 0, 0};
+        CacheKey second{{2, 0}, 0, 0}; // тот же сегмент: старшие биты совпадают
+        cache.insert(first, value);
+        CHECK(cache.find(first, found));
+        CHECK_EQUAL(7, found.result.bytes[0]);
+
+        cache.insert(second, value);
+        CHECK(!cache.find(first, found));
+        CHECK(cache.find(second, found));
+        CHECK_EQUAL(2u, cache.hits());
+        CHECK_EQUAL(1u, cache.misses());
+    }
+}
+
+/**
+ * @brief Тесты билетов возобновления сессии
+ * @details Проверяет выдачу и проверку билетов без хранения состояния на сервере
+ */
+SUITE(TicketTest) {
+    /**
+     * @brief Тест проверки билета
+     * @details Проверяет, что билет принимается только для своего логина,
+     * своего ключа, в пределах срока действия и без искажений
+     */
+    TEST(IssueAndVerify) {
+        std::string key = generateKey(32);
+        CHECK_EQUAL(32u, key.size());
+
+        time_t now = 1700000000;
+        std::string ticket = issueTicket(key, "user", now + 300);
+        CHECK(verifyTicket(key, "user", ticket, now));
+        CHECK(!verifyTicket(key, "petr", ticket, now));
+        CHECK(!verifyTicket(generateKey(32), "user", ticket, now));
+        CHECK(!verifyTicket(key, "user", ticket, now + 301));
+
+        std::string tampered = ticket;
+        tampered[tampered.size() - 1] = tampered.back() == '0' ? '1' : '0';
+        CHECK(!verifyTicket(key, "user", tampered, now));
+        CHECK(!verifyTicket(key, "user", "garbage", now));
+        CHECK(!verifyTicket(key, "user", "zz." + ticket.substr(ticket.find('.') + 1), now));
+    }
+}
+
+/**
+ * @brief Сопрограмма эха для теста реактора
+ * @param reactor Реактор
+ * @param fd Сокет
+ * @param timeouts Счетчик таймаутов ожидания (выходной параметр)
+ */
+static Task<void> echoOnce(Reactor& reactor, int fd, int& timeouts) {
+    char buffer[16];
+    ssize_t received;
+    while ((received = co_await asyncRecv(reactor, fd, buffer, sizeof(buffer), 50)) == -1 && errno == ETIMEDOUT) {
+        ++timeouts;
+    }
+    if (received > 0) {
+        co_await asyncSend(reactor, fd, buffer, received);
+    }
+}
+
+/**
+ * @brief Тесты реактора и сопрограмм
+ * @details Проверяет асинхронные операции над парой сокетов
+ */
+SUITE(ReactorTest) {
+    /**
+     * @brief Тест эха с таймаутом ожидания
+     * @details Сопрограмма сначала получает таймаут, затем принимает данные
+     * и отправляет их обратно, не блокируя поток реактора
+     */
+    TEST(EchoWithTimeout) {
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+        Reactor reactor;
+        int timeouts = 0;
+        std::thread loop([&reactor]() { reactor.run(); });
+        reactor.post([&]() { reactor.spawn(echoOnce(reactor, fds[1], timeouts)); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        CHECK_EQUAL(5, send(fds[0], "hello", 5, 0));
+        char reply[8] = {0};
+        CHECK_EQUAL(5, recv(fds[0], reply, sizeof(reply), 0));
+        CHECK_EQUAL("hello", std::string(reply));
+
+        reactor.stop();
+        loop.join();
+        CHECK(timeouts >= 1);
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+/**
+ * @brief Тесты трассировки этапов сессии
+ * @details Проверяет запись интервалов и выгрузку в формате Chrome trace-event
+ */
+SUITE(TraceTest) {
+    /**
+     * @brief Тест выгрузки трассы
+     * @details Интервалы двух сессий из разных потоков попадают в файл
+     * на дорожки своих сессий
+     */
+    TEST(ChromeExport) {
+        traceStart();
+        uint64_t first = traceSession();
+        uint64_t second = traceSession();
+        CHECK(second > first);
+        {
+            TraceSpan span("unit_phase", first);
+        }
+        std::thread([second]() { TraceSpan span("unit_phase", second); }).join();
+
+        std::string path = "/tmp/unittest_trace_" + std::to_string(getpid()) + ".json";
+        CHECK(traceExport(path) >= 2);
+        std::ifstream file(path);
+        std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        unlink(path.c_str());
+        CHECK(json.find("\"traceEvents\"") != std::string::npos);
+        CHECK(json.find("\"name\":\"unit_phase\",\"cat\":\"session\",\"ph\":\"X\"") != std::string::npos);
+        CHECK(json.find("\"tid\":" + std::to_string(second) + ",") != std::string::npos);
+        CHECK_EQUAL(-1L, traceExport("/nonexistent/dir/trace.json"));
+    }
+
+    /**
+     * @brief Тест повторного использования буферов
+     * @details Потоки, сменяющие друг друга, как потоки сессий в режиме
+     * threads, пишут в один и тот же буфер, а не заводят новый на каждый поток
+     */
+    TEST(BuffersOutliveThreadsOnce) {
+        traceStart();
+        uint64_t session = traceSession();
+        for (int i = 0; i < 20; ++i) {
+            std::thread([session]() { TraceSpan span("unit_reuse", session); }).join();
+        }
+
+        std::string path = "/tmp/unittest_trace_reuse_" + std::to_string(getpid()) + ".json";
+        CHECK(traceExport(path) >= 20);
+        std::ifstream file(path);
+        std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        unlink(path.c_str());
+
+        std::string marker = "\"tid\":" + std::to_string(session) + ",\"args\":{\"thread\":";
+        std::set<std::string> threads;
+        int events = 0;
+        for (size_t pos = json.find(marker); pos != std::string::npos; pos = json.find(marker, pos + 1)) {
+            size_t begin = pos + marker.size();
+            threads.insert(json.substr(begin, json.find('}', begin) - begin));
+            ++events;
+        }
+        CHECK_EQUAL(20, events);
+        CHECK_EQUAL(1u, threads.size());
+    }
+}
+
+/**
+ * @brief Набор тестов захвата трафика сессий
+ */
+SUITE(CaptureTest) {
+    /**
+     * @brief Тест записи и чтения файла захвата
+     * @details Записываются только сокеты с открытой сессией; записи
+     * читаются в исходном порядке с неубывающим временем
+     */
+    TEST(WriteAndLoad) {
+        std::string path = "/tmp/unittest_capture_" + std::to_string(getpid()) + ".bin";
+        CHECK(captureStart(path));
+        {
+            CaptureSession session(1000, 7);
+            captureInbound(1000, CaptureKind::Hello, "user:op=sum", 11);
+            uint32_t count = 1;
+            captureInbound(1000, CaptureKind::Data, &count, sizeof(count));
+            captureInbound(1001, CaptureKind::Data, &count, sizeof(count)); // сокет без сессии
+            captureResult(1000, 4);
+        }
+        CHECK_EQUAL(5L, captureStop());
+        CHECK(!captureRecording.load());
+
+        std::vector<CapturedSession> sessions;
+        CHECK(captureLoad(path, sessions));
+        unlink(path.c_str());
+        CHECK_EQUAL(1u, sessions.size());
+        CHECK_EQUAL(7u, sessions[0].id);
+        const std::vector<CapturedRecord>& records = sessions[0].records;
+        CHECK_EQUAL(5u, records.size());
+        CHECK(records[0].kind == CaptureKind::Begin);
+        CHECK(records[1].kind == CaptureKind::Hello);
+        CHECK_EQUAL("user:op=sum", records[1].data);
+        CHECK(records[2].kind == CaptureKind::Data);
+        CHECK_EQUAL(4u, records[2].data.size());
+        CHECK(records[3].kind == CaptureKind::Result);
+        CHECK_EQUAL(4u, records[3].size);
+        CHECK(records[4].kind == CaptureKind::End);
+        CHECK(records[4].timeNs >= records[1].timeNs);
+        CHECK(!captureLoad("/nonexistent/capture.bin", sessions));
+    }
+
+    /**
+     * @brief Тест защиты файла захвата
+     * @details Файл создается с правами 0600 и не перезаписывается, а
+     * значение билета возобновления в приветствии не сохраняется
+     */
+    TEST(PrivateFileWithoutTickets) {
+        std::string path = "/tmp/unittest_capture_private_" + std::to_string(getpid()) + ".bin";
+        CHECK(captureStart(path));
+        {
+            CaptureSession session(1000, 1);
+            std::string hello = "user:op=sum,ticket=c2VjcmV0LXRpY2tldA,session=keep";
+            captureInbound(1000, CaptureKind::Hello, hello.data(), hello.size());
+        }
+        captureStop();
+        struct stat st{};
+        CHECK_EQUAL(0, stat(path.c_str(), &st));
+        CHECK_EQUAL(0600, static_cast<int>(st.st_mode & 0777));
+        CHECK(!captureStart(path));
+
+        std::vector<CapturedSession> sessions;
+        CHECK(captureLoad(path, sessions));
+        unlink(path.c_str());
+        CHECK_EQUAL(1u, sessions.size());
+        if (sessions.size() == 1 && sessions[0].records.size() > 1) {
+            CHECK_EQUAL("user:op=sum,ticket=*,session=keep", sessions[0].records[1].data);
+        }
+    }
+
+    /**
+     * @brief Тест поврежденного и недописанного файла захвата
+     * @details Недописанная последняя запись дает false, если вызывающий не
+     * просил сообщить об обрезке, иначе отбрасывается с выставленным
+     * truncated; испорченный вид записи всегда дает false
+     */
+    TEST(TruncatedAndCorruptedTail) {
+        std::string path = "/tmp/unittest_capture_tail_" + std::to_string(getpid()) + ".bin";
+        CHECK(captureStart(path));
+        {
+            CaptureSession session(1000, 3);
+            captureInbound(1000, CaptureKind::Hello, "user", 4);
+        }
+        CHECK_EQUAL(3L, captureStop());
+
+        std::string contents;
+        {
+            std::ifstream file(path, std::ios::binary);
+            contents.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        }
+        unlink(path.c_str());
+        auto load = [&](const std::string& bytes, bool* truncated) {
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+            std::vector<CapturedSession> sessions;
+            bool ok = captureLoad(path, sessions, truncated);
+            unlink(path.c_str());
+            return ok ? static_cast<int>(sessions.empty() ? 0 : sessions[0].records.size()) : -1;
+        };
+
+        bool truncated = true;
+        CHECK_EQUAL(3, load(contents, &truncated));
+        CHECK(!truncated);
+
+        // Последняя запись (End) без байта размера
+        std::string cut = contents.substr(0, contents.size() - 1);
+        CHECK_EQUAL(-1, load(cut, nullptr));
+        CHECK_EQUAL(2, load(cut, &truncated));
+        CHECK(truncated);
+
+        // Данные приветствия обрезаны
+        cut = contents.substr(0, contents.find("user") + 2);
+        CHECK_EQUAL(1, load(cut, &truncated));
+        CHECK(truncated);
+
+        std::string corrupted = contents;
+        corrupted[8] = static_cast<char>(0x7F);
+        CHECK_EQUAL(-1, load(corrupted, &truncated));
+    }
+}
+
+/**
+ * @brief Набор тестов сжатых кодировок векторов
+ */
+SUITE(CodecTest) {
+    /**
+     * @brief Тест кодирования и свертки без восстановления вектора
+     * @details Для каждой сжатой кодировки результат совпадает со сверткой
+     * исходных элементов, в том числе на векторах длиннее блока декодера
+     */
+    TEST(RoundTrip) {
+        const ReduceKernel& sum16 = selectKernel(ReduceOp::Sum, ElemType::U16, OverflowPolicy::Saturate);
+        const ReduceKernel& min32 = selectKernel(ReduceOp::Min, ElemType::I32, OverflowPolicy::Saturate);
+        std::vector<uint16_t> small(5000);
+        for (size_t i = 0; i < small.size(); ++i) {
+            small[i] = static_cast<uint16_t>(i % 7 == 0 ? 65535 : i % 100);
+        }
+        std::vector<int32_t> signedValues = {-5, -5, -5, 2147483647, -2147483647 - 1, 0, 3};
+
+        for (PayloadEncoding encoding : {PayloadEncoding::Varint, PayloadEncoding::Delta, PayloadEncoding::Rle}) {
+            ReduceResult expected, actual;
+            bool overflow = true;
+            reduceBlock(sum16, small.data(), small.size(), expected);
+            std::vector<unsigned char> encoded = encodePayload(sum16, encoding, small.data(), small.size());
+            CHECK(encoded.size() <= maxEncodedSize(sum16, encoding, small.size()));
+            CHECK(decodeReduce(sum16, encoding, encoded.data(), encoded.size(), small.size(), actual, overflow));
+            CHECK(!overflow);
+            CHECK_EQUAL(0, std::memcmp(expected.bytes, actual.bytes, expected.size));
+
+            reduceBlock(min32, signedValues.data(), signedValues.size(), expected);
+            encoded = encodePayload(min32, encoding, signedValues.data(), signedValues.size());
+            CHECK(decodeReduce(min32, encoding, encoded.data(), encoded.size(), signedValues.size(), actual, overflow));
+            CHECK_EQUAL(0, std::memcmp(expected.bytes, actual.bytes, expected.size));
+        }
+    }
+
+    /**
+     * @brief Тест отказа на поврежденных данных и неподходящих типах
+     */
+    TEST(RejectMalformed) {
+        const ReduceKernel& sum16 = selectKernel(ReduceOp::Sum, ElemType::U16, OverflowPolicy::Saturate);
+        ReduceResult result;
+        bool overflow;
+        const unsigned char truncated[] = {0x01, 0x80};
+        const unsigned char tooWide[] = {0x80, 0x80, 0x04};    // 65536 не помещается в uint16_t
+        const unsigned char longRun[] = {0x05, 0x01};          // серия длиннее вектора
+        CHECK(!decodeReduce(sum16, PayloadEncoding::Varint, truncated, sizeof(truncated), 2, result, overflow));
+        CHECK(!decodeReduce(sum16, PayloadEncoding::Varint, tooWide, sizeof(tooWide), 1, result, overflow));
+        CHECK(!decodeReduce(sum16, PayloadEncoding::Rle, longRun, sizeof(longRun), 4, result, overflow));
+        CHECK(!decodeReduce(sum16, PayloadEncoding::Varint, longRun, sizeof(longRun), 1, result, overflow));
+
+        PayloadEncoding encoding;
+        CHECK(selectEncoding("delta", sum16, encoding));
+        CHECK(encoding == PayloadEncoding::Delta);
+        CHECK(!selectEncoding("zstd", sum16, encoding));
+        const ReduceKernel& sumF = selectKernel(ReduceOp::Sum, ElemType::F32, OverflowPolicy::Saturate);
+        CHECK(!selectEncoding("varint", sumF, encoding));
+        CHECK(selectEncoding("raw", sumF, encoding));
+    }
+}
+
+/**
+ * @brief Набор тестов транспорта через разделяемую память
+ */
+SUITE(ShmTest) {
+    /**
+     * @brief Тест колец канала
+     * @details Запись клиента в кольцо запросов видна серверу, пустое кольцо
+     * ждет до таймаута, а закрытие сокета сессии прерывает ожидание
+     */
+    TEST(RingRoundTrip) {
+        int pair[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+        ShmChannel channel(64 * 1024);
+
+        CHECK(channel.waitRequests(SHM_RECORD_ALIGN, pair[0], -1, 10) == ShmChannel::Wait::Timeout);
+
+        size_t contiguous = 0;
+        unsigned char* dst = channel.requests.back(contiguous);
+        CHECK_EQUAL(64u * 1024u, contiguous);
+        uint32_t record[2] = {42, 0};
+        std::memcpy(dst, record, sizeof(record));
+        channel.requests.publish(sizeof(record));
+
+        CHECK(channel.waitRequests(SHM_RECORD_ALIGN, pair[0], -1, 10) == ShmChannel::Wait::Ready);
+        const unsigned char* src = channel.requests.front(contiguous);
+        CHECK_EQUAL(sizeof(record), contiguous);
+        CHECK_EQUAL(42u, *reinterpret_cast<const uint32_t*>(src));
+        channel.consumeRequests(sizeof(record));
+        CHECK_EQUAL(0u, channel.requests.readable());
+
+        close(pair[1]);
+        CHECK(channel.waitRequests(SHM_RECORD_ALIGN, pair[0], -1, 1000) == ShmChannel::Wait::Closed);
+        close(pair[0]);
+    }
+
+    /**
+     * @brief Тест печатей на memfd области
+     * @details Дескриптор, который получает клиент, не позволяет ни укоротить,
+     * ни увеличить область, ни снять печати; кольца остаются доступны серверу
+     */
+    TEST(RegionSizeSealed) {
+        ShmChannel channel(64 * 1024);
+        int memfd = channel.clientFds()[0];
+        CHECK_EQUAL(-1, ftruncate(memfd, 0));
+        CHECK_EQUAL(EPERM, errno);
+        CHECK_EQUAL(-1, ftruncate(memfd, 1 << 20));
+        CHECK_EQUAL(EPERM, errno);
+        CHECK_EQUAL(-1, fcntl(memfd, F_ADD_SEALS, F_SEAL_WRITE));
+        CHECK_EQUAL(EPERM, errno);
+        CHECK_EQUAL(0u, channel.requests.readable());
+    }
+
+    /**
+     * @brief Тест счетчиков колец, испорченных клиентом
+     * @details Сервер не перечитывает из общей памяти свои счетчики: откат
+     * tail кольца запросов не возвращает прочитанные записи. Счетчик клиента
+     * дальше размера кольца от счетчика сервера дает ошибку EPROTO вместо
+     * чтения или записи за пределами кольца
+     */
+    TEST(RingCountersValidated) {
+        ShmChannel channel(64 * 1024);
+        ShmRingHeader* requests = channel.requests.header;
+        ShmRingHeader* responses = channel.responses.header;
+
+        requests->head.store(2 * SHM_RECORD_ALIGN);
+        CHECK_EQUAL(2 * SHM_RECORD_ALIGN, channel.requests.readable());
+        channel.consumeRequests(SHM_RECORD_ALIGN);
+        requests->tail.store(0);
+        size_t contiguous = 0;
+        channel.requests.front(contiguous);
+        CHECK_EQUAL(static_cast<size_t>(SHM_RECORD_ALIGN), contiguous);
+
+        requests->head.store(SHM_RECORD_ALIGN + 64 * 1024 + 1);
+        CHECK_THROW(channel.requests.readable(), std::system_error);
+        requests->head.store(0);
+        CHECK_THROW(channel.requests.front(contiguous), std::system_error);
+
+        channel.publishResponses(SHM_RECORD_ALIGN);
+        responses->head.store(0);
+        CHECK_EQUAL(64u * 1024u - SHM_RECORD_ALIGN, channel.responses.writable());
+        responses->tail.store(2 * SHM_RECORD_ALIGN);
+        CHECK_THROW(channel.responses.back(contiguous), std::system_error);
+    }
+}
+
+/**
+ * @brief Тесты базы пользователей в разделяемой памяти
+ */
+SUITE(UserBaseTest) {
+    /**
+     * @brief Тест загрузки и поиска
+     * @details Комментарии и строки без ':' пропускаются, пробелы по краям
+     * отбрасываются, из повторяющихся логинов используется первый
+     */
+    TEST(LoadAndFind) {
+        std::string path = "/tmp/unittest_base_" + std::to_string(getpid()) + ".txt";
+        {
+            std::ofstream file(path);
+            file << "# comment\n; comment\nbob:secret\n  alice \t: pass word \nbroken line\nbob:other\n";
+        }
+        UserBase base;
+        CHECK(base.load(path));
+        unlink(path.c_str());
+        CHECK(!base.compiled());
+        CHECK_EQUAL(2u, base.size());
+
+        std::string password;
+        CHECK(base.find("alice", password));
+        CHECK_EQUAL("pass word", password);
+        CHECK(base.find("bob", password));
+        CHECK_EQUAL("secret", password);
+        CHECK(!base.find("carol", password));
+        CHECK(!base.find("", password));
+
+        UserBase missing;
+        CHECK(!missing.load("/nonexistent/base.txt"));
+        CHECK(!missing.find("bob", password));
+    }
+
+    /**
+     * @brief Тест индекса с совершенной хеш-функцией
+     * @details Индекс из 10000 логинов записывается в файл, отображается в
+     * память и находит каждый логин; поврежденный заголовок отвергается
+     */
+    TEST(CompiledIndex) {
+        std::vector<std::pair<std::string, std::string>> users;
+        for (int i = 0; i < 10000; ++i) {
+            users.emplace_back("user" + std::to_string(i), "pass" + std::to_string(i * 7));
+        }
+        std::vector<unsigned char> image = UserBase::compile(users);
+        CHECK(!image.empty());
+
+        std::string path = "/tmp/unittest_index_" + std::to_string(getpid()) + ".idx";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(image.data()), image.size());
+        }
+        UserBase base;
+        CHECK(base.load(path));
+        CHECK(base.compiled());
+        CHECK_EQUAL(users.size(), base.size());
+        std::string password;
+        int found = 0;
+        for (const auto& user : users) {
+            found += base.find(user.first, password) && password == user.second;
+        }
+        CHECK_EQUAL(10000, found);
+        CHECK(!base.find("user10000", password));
+
+        // Усеченный индекс не загружается, прежний остается доступным
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(image.data()), image.size() - 1);
+        }
+        CHECK(!base.load(path));
+        unlink(path.c_str());
+        CHECK(base.find("user42", password));
+        CHECK_EQUAL("pass294", password);
+    }
+}
+
+/**
+ * @brief Тесты передачи сокетов между процессами
+ */
+SUITE(HandoffTest) {
+    /**
+     * @brief Тест удаления файла сокета перед запуском
+     * @details Путь работающего сервера не освобождается, файл сокета без
+     * слушателя удаляется, файл другого типа не трогается
+     */
+    TEST(StaleSocketRemoval) {
+        std::string path = "/tmp/unittest_stale_" + std::to_string(getpid()) + ".sock";
+        unlink(path.c_str());
+        CHECK(removeStaleSocket(path));
+
+        int live = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        CHECK_EQUAL(0, bind(live, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        CHECK_EQUAL(0, listen(live, 1));
+        CHECK(!removeStaleSocket(path));
+        CHECK_EQUAL(0, access(path.c_str(), F_OK));
+
+        close(live);
+        CHECK(removeStaleSocket(path));
+        CHECK(access(path.c_str(), F_OK) != 0);
+
+        std::ofstream(path) << "data";
+        CHECK(removeStaleSocket(path));
+        CHECK_EQUAL(0, access(path.c_str(), F_OK));
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * @brief Тесты вспомогательных функций супервизора
+ */
+SUITE(SupervisorTest) {
+    /**
+     * @brief Тест разбора списка процессоров sysfs
+     */
+    TEST(CpuList) {
+        std::vector<int> cpus;
+        CHECK(parseCpuList("0-3,8,10-11\n", cpus));
+        CHECK_EQUAL(7u, cpus.size());
+        CHECK_EQUAL(0, cpus.front());
+        CHECK_EQUAL(11, cpus.back());
+        CHECK(!parseCpuList("", cpus));
+        CHECK(!parseCpuList("3-1", cpus));
+        CHECK(!parseCpuList("a-b", cpus));
+    }
+
+    /**
+     * @brief Тест задержки перезапуска
+     * @details Задержка удваивается при быстрых падениях, ограничена сверху
+     * и сбрасывается после стабильной работы
+     */
+    TEST(RestartBackoff) {
+        long delay = restartDelay(0, 0);
+        CHECK_EQUAL(RESTART_DELAY_MIN_MS, delay);
+        delay = restartDelay(delay, 50);
+        CHECK_EQUAL(2 * RESTART_DELAY_MIN_MS, delay);
+        for (int i = 0; i < 20; ++i) {
+            delay = restartDelay(delay, 50);
+        }
+        CHECK_EQUAL(RESTART_DELAY_MAX_MS, delay);
+        CHECK_EQUAL(RESTART_DELAY_MIN_MS, restartDelay(delay, RESTART_STABLE_MS));
+    }
+}
+
+/**
+ * @brief Тесты TLS с шифрованием записей в ядре
+ */
+SUITE(TlsTest) {
+    /**
+     * @brief Создание самоподписанного сертификата и ключа
+     * @param certPath Файл сертификата
+     * @param keyPath Файл ключа
+     * @return false при ошибке OpenSSL
+     */
+    static bool writeSelfSigned(const std::string& certPath, const std::string& keyPath) {
+        EVP_PKEY* key = EVP_EC_gen("prime256v1");
+        X509* cert = X509_new();
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, X509_get_subject_name(cert));
+        bool ok = key != nullptr && X509_sign(cert, key, EVP_sha256()) > 0;
+        FILE* certFile = fopen(certPath.c_str(), "w");
+        FILE* keyFile = fopen(keyPath.c_str(), "w");
+        ok = ok && certFile && keyFile && PEM_write_X509(certFile, cert) == 1
+             && PEM_write_PrivateKey(keyFile, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+        if (certFile) fclose(certFile);
+        if (keyFile) fclose(keyFile);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return ok;
+    }
+
+    /**
+     * @brief Тест рукопожатия с самоподписанным сертификатом
+     * @details Клиент OpenSSL подключается по TCP на петлевом интерфейсе.
+     * Если ядро поддерживает kTLS, рукопожатие завершается и сервер читает
+     * расшифрованные ядром данные обычным recv; иначе рукопожатие
+     * отвергается, а не продолжается открытым текстом
+     */
+    TEST(SelfSignedHandshake) {
+        std::string certPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".crt";
+        std::string keyPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".key";
+        CHECK(writeSelfSigned(certPath, keyPath));
+        TlsContext context;
+        std::string error;
+        CHECK(context.init(certPath, keyPath, error));
+        CHECK(!context.init("/nonexistent/server.crt", keyPath, error));
+        CHECK(!error.empty());
+        unlink(certPath.c_str());
+        unlink(keyPath.c_str());
+
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        CHECK_EQUAL(0, bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        CHECK_EQUAL(0, listen(listener, 1));
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+
+        std::thread client([addr]() {
+            SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+            SSL* ssl = SSL_new(ctx);
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+                SSL_set_fd(ssl, fd);
+                if (SSL_connect(ssl) == 1) {
+                    SSL_write(ssl, "ping", 4);
+                }
+            }
+            SSL_free(ssl);
+            SSL_CTX_free(ctx);
+            close(fd);
+        });
+
+        int server = accept(listener, nullptr, nullptr);
+        TlsStep step;
+        {
+            TlsHandshake handshake(context, server);
+            while ((step = handshake.step()) == TlsStep::WantRead || step == TlsStep::WantWrite) {
+            }
+            if (step == TlsStep::Failed) {
+                CHECK(!handshake.error().empty());
+            }
+        }
+        if (tlsKernelSupported()) {
+            CHECK(step == TlsStep::Done);
+            char buffer[4] = {};
+            CHECK_EQUAL(4, static_cast<int>(recv(server, buffer, sizeof(buffer), MSG_WAITALL)));
+            CHECK(std::memcmp(buffer, "ping", 4) == 0);
+        } else {
+            CHECK(step == TlsStep::Failed);
+        }
+        close(server);
+        client.join();
+        close(listener);
+    }
+
+    /**
+     * @brief Слушающий сокет на свободном порту петлевого интерфейса
+     * @param addr Адрес сокета (выходной параметр)
+     * @return Слушающий сокет
+     */
+    static int loopbackListener(sockaddr_in& addr) {
+        int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        addr = sockaddr_in{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listener, 1);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+        return listener;
+    }
+
+    /**
+     * @brief Тест ограничения времени рукопожатия на блокирующем сокете
+     * @details Клиент присылает начало заголовка записи и замолкает:
+     * рукопожатие завершается ошибкой по истечении времени, а не ждет в
+     * read(), и сокет возвращается в блокирующий режим
+     */
+    TEST(StalledClientTimeout) {
+        std::string certPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".crt";
+        std::string keyPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".key";
+        CHECK(writeSelfSigned(certPath, keyPath));
+        TlsContext context;
+        std::string error;
+        CHECK(context.init(certPath, keyPath, error));
+        unlink(certPath.c_str());
+        unlink(keyPath.c_str());
+
+        sockaddr_in addr;
+        int listener = loopbackListener(addr);
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK_EQUAL(0, connect(client, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)));
+        CHECK_EQUAL(3, static_cast<int>(send(client, "\x16\x03\x01", 3, 0)));
+        int server = accept(listener, nullptr, nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+        TlsHandshake handshake(context, server);
+        CHECK(handshake.run(200) == TlsStep::Failed);
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+        CHECK(!handshake.error().empty());
+        CHECK(!(fcntl(server, F_GETFL) & O_NONBLOCK));
+        close(server);
+        close(client);
+        close(listener);
+    }
+
+    /**
+     * @brief Рукопожатие на сокете, принятом реактором
+     * @param reactor Реактор
+     * @param listener Неблокирующий слушающий сокет
+     * @param context Серверный контекст
+     * @param nonBlocking Был ли принятый сокет неблокирующим (выходной параметр)
+     * @param step Результат первого шага рукопожатия (выходной параметр)
+     * @param done Признак завершения
+     */
+    static Task<void> acceptAndStep(Reactor& reactor, int listener, const TlsContext& context,
+                                    bool& nonBlocking, TlsStep& step, std::atomic<bool>& done) {
+        int fd = co_await asyncAccept(reactor, listener, nullptr, nullptr);
+        nonBlocking = fd != -1 && (fcntl(fd, F_GETFL) & O_NONBLOCK);
+        {
+            TlsHandshake handshake(context, fd);
+            step = handshake.step();
+        }
+        close(fd);
+        done = true;
+    }
+
+    /**
+     * @brief Тест рукопожатия в режиме сопрограмм с молчащим клиентом
+     * @details Сокет, принятый asyncAccept, неблокирующий, поэтому шаг
+     * рукопожатия сразу возвращает WantRead, а не блокирует поток реактора
+     * до закрытия соединения клиентом
+     */
+    TEST(ReactorAcceptNonBlocking) {
+        std::string certPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".crt";
+        std::string keyPath = "/tmp/unittest_tls_" + std::to_string(getpid()) + ".key";
+        CHECK(writeSelfSigned(certPath, keyPath));
+        TlsContext context;
+        std::string error;
+        CHECK(context.init(certPath, keyPath, error));
+        unlink(certPath.c_str());
+        unlink(keyPath.c_str());
+
+        sockaddr_in addr;
+        int listener = loopbackListener(addr);
+        fcntl(listener, F_SETFL, O_NONBLOCK);
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        CHECK_EQUAL(0, connect(client, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)));
+
+        Reactor reactor;
+        bool nonBlocking = false;
+        TlsStep step = TlsStep::Done;
+        std::atomic<bool> done(false);
+        std::thread loop([&reactor]() { reactor.run(); });
+        // При блокирующем сокете шаг рукопожатия вернется только после
+        // закрытия соединения клиентом, и уже с ошибкой
+        std::thread silent([client]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            shutdown(client, SHUT_WR);
+        });
+        reactor.post([&]() { reactor.spawn(acceptAndStep(reactor, listener, context, nonBlocking, step, done)); });
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        silent.join();
+        reactor.stop();
+        loop.join();
+        CHECK(nonBlocking);
+        CHECK(step == TlsStep::WantRead);
+        close(client);
+        close(listener);
+    }
+}
+
+/**
+ * @brief Параметры сервера для сессий внутри процесса теста
+ * @return Параметры по умолчанию с базой из одного пользователя
+ * @details findUserInFile загружает базу при первом обращении и дальше
+ * использует ее, поэтому база создается один раз на процесс
+ */
+static const Params& harnessParams() {
+    static const Params params = []() {
+        signal(SIGPIPE, SIG_IGN);
+        std::string base = "/tmp/unittest_harness_" + std::to_string(getpid()) + ".txt";
+        std::string log = "/tmp/unittest_harness_" + std::to_string(getpid()) + ".log";
+        std::ofstream(base) << "harness:pw\n";
+        UserInterface iface;
+        const char* argv[] = {"test", "-b", base.c_str(), "-j", log.c_str(), "-l", log.c_str(),
+                              "-p", "33333", "--max-vector", "64", nullptr};
+        iface.Parser(sizeof(argv) / sizeof(argv[0]) - 1, argv);
+        return iface.getParams();
+    }();
+    return params;
+}
+
+/**
+ * @struct HarnessScript
+ * @brief Сценарий клиента одной сессии
+ * @details На векторе больше Params::maxVectorSize сценарий обрывается:
+ * сервер отвечает на предыдущие векторы и закрывает сессию (см. shm.h)
+ */
+struct HarnessScript {
+    std::string op = "product";     ///< Операция свертки
+    std::string ovf = "saturate";   ///< Политика переполнения
+    bool keepAlive = false;         ///< Постоянная сессия с END_OF_SESSION в конце
+    bool split = false;             ///< Отправка данных частями по 1-7 байт
+    size_t resetAt = 0;             ///< Закрыть соединение после стольких байт данных (0 - не закрывать)
+    std::vector<std::vector<std::vector<uint16_t>>> batches; ///< Пачки векторов
+};
+
+/**
+ * @brief Случайный сценарий
+ * @param rng Генератор с фиксированным зерном
+ * @param p Параметры сервера
+ * @return Сценарий с разбиением кадров, склейкой пачек, переполнением,
+ * слишком большими векторами и обрывом соединения
+ */
+static HarnessScript harnessRandomScript(std::mt19937& rng, const Params& p) {
+    HarnessScript script;
+    script.op = rng() % 2 ? "sum" : "product";
+    script.keepAlive = rng() % 2;
+    script.split = rng() % 3 == 0;
+    size_t batches = script.keepAlive ? 1 + rng() % 3 : 1;
+    for (size_t b = 0; b < batches; ++b) {
+        std::vector<std::vector<uint16_t>> batch(rng() % 5);
+        for (auto& vector : batch) {
+            uint32_t kind = rng() % 10;
+            if (kind == 0) {
+                vector.assign(p.maxVectorSize + 1 + rng() % 16, 0);
+            } else if (kind == 1) {
+                vector.assign(1 + rng() % p.maxVectorSize, 65535);
+            } else {
+                vector.resize(rng() % (p.maxVectorSize + 1));
+                for (auto& elem : vector) {
+                    elem = static_cast<uint16_t>(rng() % 8);
+                }
+            }
+        }
+        script.batches.push_back(std::move(batch));
+    }
+    if (rng() % 10 == 0) {
+        script.resetAt = 1 + rng() % 16;
+    }
+    return script;
+}
+
+/**
+ * @brief Вход клиента: приветствие, соль и хеш
+ * @param fd Сокет клиента
+ * @param options Параметры приветствия
+ * @param shmFds Дескрипторы разделяемой памяти из ответа (nullptr - не принимать)
+ * @return true, если сервер ответил "OK" (и передал дескрипторы, если они ожидаются)
+ * @details Приветствие и хеш отправляются целиком: сервер читает каждое
+ * одним вызовом recv
+ */
+static bool harnessLogin(int fd, const std::string& options, int* shmFds = nullptr) {
+    std::string hello = "harness:" + options;
+    if (send(fd, hello.data(), hello.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(hello.size())) {
+        return false;
+    }
+    char buffer[BUFFER_SIZE];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+        return false;
+    }
+    std::string hash = auth(std::string(buffer, received), "pw");
+    if (send(fd, hash.data(), hash.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(hash.size())) {
+        return false;
+    }
+
+    iovec iov = {buffer, sizeof(buffer)};
+    alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    received = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (received != 2 || std::memcmp(buffer, "OK", 2) != 0) {
+        return false;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (shmFds != nullptr) {
+        if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int))) {
+            return false;
+        }
+        std::memcpy(shmFds, CMSG_DATA(cmsg), 3 * sizeof(int));
+    }
+    return shmFds != nullptr || cmsg == nullptr;
+}
+
+/**
+ * @brief Выполнение сценария на стороне клиента
+ * @param fd Сокет клиента
+ * @param script Сценарий
+ * @param rng Генератор для разбиения кадров
+ * @param p Параметры сервера
+ * @return true, если все результаты совпали с эталонной сверткой и сервер
+ * закрыл соединение после сессии
+ */
+static bool harnessClient(int fd, const HarnessScript& script, std::mt19937& rng, const Params& p) {
+    std::string options = "op=" + script.op + ",ovf=" + script.ovf;
+    if (script.keepAlive) {
+        options += ",session=keep";
+    }
+    if (!harnessLogin(fd, options)) {
+        return false;
+    }
+    const ReduceKernel* kernel = selectKernel(script.op, "uint16", script.ovf);
+
+    std::vector<unsigned char> stream, expected;
+    auto put = [&stream](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        stream.insert(stream.end(), bytes, bytes + size);
+    };
+    bool rejected = false;
+    for (size_t b = 0; b < script.batches.size() && !rejected; ++b) {
+        uint32_t count = script.batches[b].size();
+        put(&count, sizeof(count));
+        for (const auto& vector : script.batches[b]) {
+            uint32_t size = vector.size();
+            put(&size, sizeof(size));
+            // Сервер закрывает сессию, не читая элементов слишком большого вектора
+            if (size > p.maxVectorSize) {
+                rejected = true;
+                break;
+            }
+            put(vector.data(), size * sizeof(uint16_t));
+            ReduceResult result;
+            reduceBlock(*kernel, vector.data(), size, result);
+            expected.insert(expected.end(), result.bytes, result.bytes + kernel->resultSize);
+        }
+    }
+    if (script.keepAlive && !rejected) {
+        uint32_t end = END_OF_SESSION;
+        put(&end, sizeof(end));
+    }
+    if (script.resetAt != 0) {
+        stream.resize(std::min(stream.size(), script.resetAt));
+    }
+
+    for (size_t offset = 0; offset < stream.size(); ) {
+        size_t part = script.split ? std::min<size_t>(stream.size() - offset, 1 + rng() % 7) : stream.size() - offset;
+        if (send(fd, stream.data() + offset, part, MSG_NOSIGNAL) != static_cast<ssize_t>(part)) {
+            return false;
+        }
+        offset += part;
+    }
+    if (script.resetAt != 0) {
+        return true;
+    }
+
+    std::vector<unsigned char> results(expected.size());
+    if (!results.empty() && recv(fd, results.data(), results.size(), MSG_WAITALL) != static_cast<ssize_t>(results.size())) {
+        return false;
+    }
+    char extra;
+    return results == expected && recv(fd, &extra, 1, 0) == 0;
+}
+
+/**
+ * @brief Сессия сервера в сопрограмме с закрытием сокета
+ * @param reactor Реактор
+ * @param fd Сокет сервера
+ * @param p Параметры сервера
+ * @param finished Счетчик завершенных сессий
+ */
+static Task<void> harnessAsyncSession(Reactor& reactor, int fd, const Params* p, std::atomic<int>* finished) {
+    co_await Connection::asyncSession(reactor, fd, p);
+    close(fd);
+    finished->fetch_add(1);
+}
+
+/**
+ * @brief Запуск серверной стороны сессии
+ * @param fd Сокет сервера как есть, без изменения флагов
+ * @param reactor Реактор для режима сопрограмм (nullptr - поток на сессию)
+ * @param finished Счетчик завершенных сессий в реакторе
+ * @return Поток сессии (пустой в режиме сопрограмм)
+ */
+static std::thread harnessServe(int fd, Reactor* reactor, std::atomic<int>* finished) {
+    const Params* p = &harnessParams();
+    if (reactor != nullptr) {
+        reactor->post([reactor, fd, p, finished]() { reactor->spawn(harnessAsyncSession(*reactor, fd, p, finished)); });
+        return std::thread();
+    }
+    return std::thread([fd, p]() {
+        Connection::session(fd, p);
+        close(fd);
+    });
+}
+
+/**
+ * @brief Сессия по сценарию через пару сокетов
+ * @param script Сценарий клиента
+ * @param rng Генератор для разбиения кадров
+ * @param reactor Реактор для режима сопрограмм (nullptr - поток на сессию)
+ * @param finished Счетчик завершенных сессий в реакторе
+ * @return Результат harnessClient
+ */
+static bool harnessRun(const HarnessScript& script, std::mt19937& rng, Reactor* reactor = nullptr,
+                       std::atomic<int>* finished = nullptr) {
+    const Params& p = harnessParams();
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        return false;
+    }
+    std::thread server = harnessServe(fds[1], reactor, finished);
+    bool ok = harnessClient(fds[0], script, rng, p);
+    close(fds[0]);
+    if (server.joinable()) {
+        server.join();
+    }
+    return ok;
+}
+
+/**
+ * @brief Запрос, на который сервер должен закрыть сессию без ответа
+ * @param options Параметры приветствия
+ * @param request Слова запроса после аутентификации
+ * @param reactor Реактор для режима сопрограмм (nullptr - поток на сессию)
+ * @param finished Счетчик завершенных сессий в реакторе
+ * @return true, если сервер закрыл сессию, не прислав ни одного результата
+ */
+static bool harnessRejected(const std::string& options, const std::vector<uint32_t>& request,
+                            Reactor* reactor = nullptr, std::atomic<int>* finished = nullptr) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        return false;
+    }
+    std::thread server = harnessServe(fds[1], reactor, finished);
+    bool rejected = harnessLogin(fds[0], options);
+    if (rejected) {
+        // Сервер может закрыть сокет, не дочитав запрос: ошибку send не проверяем
+        send(fds[0], request.data(), request.size() * sizeof(uint32_t), MSG_NOSIGNAL);
+        // Закрытие с непрочитанными данными дает 0 или ECONNRESET
+        uint32_t result;
+        rejected = recv(fds[0], &result, sizeof(result), MSG_WAITALL) <= 0;
+    }
+    close(fds[0]);
+    if (server.joinable()) {
+        server.join();
+    }
+    return rejected;
+}
+
+/**
+ * @brief Тесты протокола сессии через пару сокетов внутри процесса
+ * @details Сервер обслуживает один конец socketpair функцией
+ * Connection::session или Connection::asyncSession, клиент по сценарию
+ * работает с другим концом; сеть и слушающий сокет не нужны
+ */
+SUITE(HarnessTest) {
+    /**
+     * @brief Тест сценариев протокола
+     * @details Разбитые на части и склеенные кадры, постоянная сессия и
+     * насыщение при переполнении дают эталонные результаты в обоих режимах
+     * сессий; слишком большой вектор закрывает сессию после ответов на
+     * предыдущие векторы
+     */
+    TEST(ScriptedSessions) {
+        const Params& p = harnessParams();
+        std::mt19937 rng(42);
+        Reactor reactor;
+        std::atomic<int> finished(0);
+        std::thread loop([&reactor]() { reactor.run(); });
+
+        HarnessScript basic;
+        basic.batches = {{{1, 2, 3, 4, 5, 6, 7, 8, 9}}};
+        HarnessScript split = basic;
+        split.split = true;
+        HarnessScript keep;
+        keep.op = "sum";
+        keep.keepAlive = true;
+        keep.batches = {{{1, 2}, {3}}, {}, {{65535, 65535}}};
+        HarnessScript overflow;
+        overflow.batches = {{std::vector<uint16_t>(12, 65535), std::vector<uint16_t>(p.maxVectorSize + 1, 1), {2, 3}}};
+
+        for (Reactor* mode : {static_cast<Reactor*>(nullptr), &reactor}) {
+            CHECK(harnessRun(basic, rng, mode, &finished));
+            CHECK(harnessRun(split, rng, mode, &finished));
+            CHECK(harnessRun(keep, rng, mode, &finished));
+            CHECK(harnessRun(overflow, rng, mode, &finished));
+        }
+
+        // Эталон независимо от reduceBlock: 9! и насыщение до UINT32_MAX
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        std::thread server([&]() { Connection::session(fds[1], &p); close(fds[1]); });
+        CHECK(harnessLogin(fds[0], "op=product"));
+        uint32_t request[] = {2, 2, 0x00090008u, 4, 0xFFFFFFFFu, 0xFFFFFFFFu};
+        send(fds[0], request, sizeof(request), MSG_NOSIGNAL);
+        uint32_t results[2] = {};
+        CHECK_EQUAL(8, static_cast<int>(recv(fds[0], results, sizeof(results), MSG_WAITALL)));
+        CHECK_EQUAL(72u, results[0]);
+        CHECK_EQUAL(UINT32_MAX, results[1]);
+        close(fds[0]);
+        server.join();
+
+        while (finished.load() < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reactor.stop();
+        loop.join();
+    }
+
+    /**
+     * @brief Тест обрыва соединения и переполнения с политикой error
+     * @details Сессия, оборванная посреди вектора, завершается без
+     * зависания, а переполнение с ovf=error закрывает соединение без результата
+     */
+    TEST(ResetAndOverflowError) {
+        const Params& p = harnessParams();
+        std::mt19937 rng(7);
+        for (size_t cut = 1; cut <= 12; ++cut) {
+            HarnessScript reset;
+            reset.split = cut % 2;
+            reset.resetAt = cut;
+            reset.batches = {{{1, 2, 3}}};
+            CHECK(harnessRun(reset, rng));
+        }
+
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        std::thread server([&]() { Connection::session(fds[1], &p); close(fds[1]); });
+        CHECK(harnessLogin(fds[0], "op=product,ovf=error"));
+        uint32_t request[] = {1, 4, 0xFFFFFFFFu, 0xFFFFFFFFu};
+        send(fds[0], request, sizeof(request), MSG_NOSIGNAL);
+        uint32_t result;
+        CHECK_EQUAL(0, static_cast<int>(recv(fds[0], &result, sizeof(result), MSG_WAITALL)));
+        close(fds[0]);
+        server.join();
+    }
+
+    /**
+     * @brief Тест пачки больше MAX_BATCH_VECTORS в постоянной сессии
+     * @details Пачка не обрезается: иначе непрочитанные векторы были бы
+     * приняты за следующую пачку. Сессия закрывается, не отправив ни одного
+     * результата, в том числе для второй пачки
+     */
+    TEST(OversizedBatchClosesSession) {
+        const Params& p = harnessParams();
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        std::thread server([&]() { Connection::session(fds[1], &p); close(fds[1]); });
+        CHECK(harnessLogin(fds[0], "op=sum,session=keep"));
+
+        std::vector<uint32_t> request = {MAX_BATCH_VECTORS + 1};
+        for (uint32_t i = 0; i <= MAX_BATCH_VECTORS; ++i) {
+            request.push_back(2);
+            request.push_back(0x00010001u);
+        }
+        request.insert(request.end(), {1, 2, 0x00030002u, END_OF_SESSION});
+        send(fds[0], request.data(), request.size() * sizeof(uint32_t), MSG_NOSIGNAL);
+        // Сервер закрывает сокет с непрочитанными данными: 0 или ECONNRESET
+        uint32_t result;
+        CHECK(recv(fds[0], &result, sizeof(result), MSG_WAITALL) <= 0);
+        close(fds[0]);
+        server.join();
+    }
+
+    /**
+     * @brief Тест отказа в постоянной сессии в обоих режимах
+     * @details Пачка больше MAX_BATCH_VECTORS и закодированный вектор больше
+     * предела кодировки приходят в постоянной сессии вместе со следующей
+     * пачкой. Потоковая сессия и сопрограмма на сокете без флагов закрывают
+     * соединение, не ответив ни на одну из пачек
+     */
+    TEST(KeepAliveRejectsInBothModes) {
+        std::vector<uint32_t> batch = {MAX_BATCH_VECTORS + 1};
+        for (uint32_t i = 0; i <= MAX_BATCH_VECTORS; ++i) {
+            batch.push_back(2);
+            batch.push_back(0x00010001u);
+        }
+        batch.insert(batch.end(), {1, 2, 0x00030002u, END_OF_SESSION});
+        // Вектор из двух элементов с заявленным размером кодировки 1 МиБ
+        std::vector<uint32_t> encoded = {1, 2, 1u << 20, 0x01010101u, 1, 2, 0x00030002u, END_OF_SESSION};
+
+        Reactor reactor;
+        std::atomic<int> finished(0);
+        std::thread loop([&reactor]() { reactor.run(); });
+        for (Reactor* mode : {static_cast<Reactor*>(nullptr), &reactor}) {
+            CHECK(harnessRejected("op=sum,session=keep", batch, mode, &finished));
+            CHECK(harnessRejected("op=sum,session=keep,enc=varint", encoded, mode, &finished));
+        }
+        while (finished.load() < 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reactor.stop();
+        loop.join();
+    }
+
+    /**
+     * @brief Тест слишком большого вектора в обоих транспортах
+     * @details Клиент присылает вектор {2, 3} и вслед за ним заголовок
+     * вектора больше Params::maxVectorSize без элементов. И через сокет, и
+     * через разделяемую память сервер отвечает на первый вектор и закрывает
+     * сессию, не ожидая элементов второго
+     */
+    TEST(OversizedVectorSameInBothTransports) {
+        const Params& p = harnessParams();
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        std::thread server([&]() { Connection::session(fds[1], &p); close(fds[1]); });
+        CHECK(harnessLogin(fds[0], "op=sum"));
+        uint32_t request[] = {2, 2, 0x00030002u, p.maxVectorSize + 1};
+        send(fds[0], request, sizeof(request), MSG_NOSIGNAL);
+        uint32_t result = 0;
+        CHECK_EQUAL(4, static_cast<int>(recv(fds[0], &result, sizeof(result), MSG_WAITALL)));
+        CHECK_EQUAL(5u, result);
+        CHECK_EQUAL(0, static_cast<int>(recv(fds[0], &result, sizeof(result), MSG_WAITALL)));
+        close(fds[0]);
+        server.join();
+
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        server = std::thread([&]() { Connection::session(fds[1], &p); close(fds[1]); });
+        int shmFds[3] = {-1, -1, -1};
+        CHECK(harnessLogin(fds[0], "op=sum,transport=shm", shmFds));
+        struct stat st{};
+        fstat(shmFds[0], &st);
+        void* area = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFds[0], 0);
+        CHECK(area != MAP_FAILED);
+        if (area != MAP_FAILED) {
+            ShmHeader* header = static_cast<ShmHeader*>(area);
+            unsigned char* base = static_cast<unsigned char*>(area);
+            ShmRing requests(&header->requests, base + SHM_HEADER_SIZE, header->ringSize);
+            ShmRing responses(&header->responses, base + SHM_HEADER_SIZE + header->ringSize, header->ringSize);
+
+            // Записи кольца выровнены на 8 байт
+            uint32_t records[] = {2, 0, 2, 0, 0x00030002u, 0, p.maxVectorSize + 1, 0};
+            size_t contiguous;
+            std::memcpy(requests.back(contiguous), records, sizeof(records));
+            requests.publish(sizeof(records));
+            uint64_t one = 1;
+            CHECK_EQUAL(8, static_cast<int>(write(shmFds[1], &one, sizeof(one))));
+
+            pollfd pfd = {fds[0], POLLIN, 0};
+            CHECK_EQUAL(1, poll(&pfd, 1, 5000));
+            CHECK_EQUAL(0, static_cast<int>(recv(fds[0], &result, sizeof(result), 0)));
+            server.join();
+            CHECK_EQUAL(static_cast<size_t>(SHM_RECORD_ALIGN), responses.readable());
+            std::memcpy(&result, responses.front(contiguous), sizeof(result));
+            CHECK_EQUAL(5u, result);
+            munmap(area, st.st_size);
+        } else {
+            close(fds[0]);
+            server.join();
+        }
+        close(fds[0]);
+        for (int fd : shmFds) {
+            close(fd);
+        }
+    }
+
+    /**
+     * @brief Тест выдачи билетов только по каналам без прослушивания
+     * @details Через Unix-сокет билет выдается и пропускает обмен солью; тот
+     * же билет на TCP без TLS не принимается, и сервер присылает соль, а
+     * запрос билета на TCP получает ответ "OK" без билета
+     */
+    TEST(TicketsOnlyOnPrivateChannels) {
+        Params unixParams = harnessParams();
+        unixParams.addressFamily = AF_UNIX;
+        Params tcpParams = harnessParams();
+        tcpParams.addressFamily = AF_INET;
+        CHECK(unixParams.ticketLifetime > 0);
+
+        // Первый ответ сервера на приветствие и, если это соль, ответ на хеш
+        auto exchange = [](const Params& p, const std::string& hello, std::string& first, std::string& reply) {
+            int fds[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+            std::thread server([&p, fd = fds[1]]() { Connection::session(fd, &p); close(fd); });
+            char buffer[BUFFER_SIZE];
+            send(fds[0], hello.data(), hello.size(), MSG_NOSIGNAL);
+            ssize_t received = recv(fds[0], buffer, sizeof(buffer), 0);
+            first.assign(buffer, std::max<ssize_t>(received, 0));
+            reply.clear();
+            if (first != "OK") {
+                std::string hash = auth(first, "pw");
+                send(fds[0], hash.data(), hash.size(), MSG_NOSIGNAL);
+                received = recv(fds[0], buffer, sizeof(buffer), 0);
+                reply.assign(buffer, std::max<ssize_t>(received, 0));
+            }
+            uint32_t count = 0;
+            send(fds[0], &count, sizeof(count), MSG_NOSIGNAL);
+            close(fds[0]);
+            server.join();
+        };
+
+        std::string first, reply;
+        exchange(unixParams, "harness:resume", first, reply);
+        CHECK(reply.compare(0, 3, "OK:") == 0);
+        std::string ticket = reply.size() > 3 ? reply.substr(3) : "";
+
+        exchange(unixParams, "harness:ticket=" + ticket, first, reply);
+        CHECK_EQUAL("OK", first);
+
+        exchange(tcpParams, "harness:ticket=" + ticket, first, reply);
+        CHECK(first != "OK");
+        CHECK_EQUAL("OK", reply);
+
+        exchange(tcpParams, "harness:resume", first, reply);
+        CHECK_EQUAL("OK", reply);
+    }
+
+    /**
+     * @brief Нагрузочный тест случайных сценариев
+     * @details Тысячи сессий со сценариями из генератора с фиксированным
+     * зерном поочередно в обоих режимах
+     */
+    TEST(SoakThroughput) {
+        const Params& p = harnessParams();
+        const int sessions = 2000;
+        std::mt19937 rng(2025);
+        Reactor reactor;
+        std::atomic<int> finished(0);
+        std::thread loop([&reactor]() { reactor.run(); });
+
+        int passed = 0;
+        for (int i = 0; i < sessions; ++i) {
+            HarnessScript script = harnessRandomScript(rng, p);
+            passed += harnessRun(script, rng, i % 2 ? &reactor : nullptr, &finished);
+        }
+        while (finished.load() < sessions / 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reactor.stop();
+        loop.join();
+
+        CHECK_EQUAL(sessions, passed);
+        unlink(p.inFileName.c_str());
+        unlink(p.logFile.c_str());
+    }
 }
 
 /**
@@ -0,0 +1,132 @@
+/**
+ * @file basec.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Компилятор базы пользователей в индекс с совершенной хеш-функцией
+ * @details Читает текстовую базу "логин:пароль" по тем же правилам, что и
+ * сервер, собирает индекс (см. userbase.h) и записывает его атомарно через
+ * временный файл и rename, поэтому сервер, отобразивший прежний индекс, не
+ * увидит частично записанный файл. После записи индекс загружается заново
+ * и проверяется поиском каждого пользователя
+ */
+
+#include "userbase.h"
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Запись файла через временный файл
+ * @param path Имя файла
+ * @param data Содержимое
+ * @return false при ошибке записи
+ * @details Индекс хранит пароли открытым текстом, поэтому файл доступен
+ * только владельцу (0600) еще до переименования, в том числе если
+ * временный файл остался от прерванного запуска
+ */
+static bool writeAtomically(const std::string& path, const std::vector<unsigned char>& data) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    if (fchmod(fd, 0600) != 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return false;
+    }
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            close(fd);
+            unlink(tmp.c_str());
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (fsync(fd) != 0 || close(fd) != 0 || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Главная функция компилятора базы
+ * @param argc Количество аргументов командной строки
+ * @param argv Массив аргументов командной строки
+ * @return Код завершения (0 - индекс записан и проверен, 1 - ошибка)
+ */
+int main(int argc, const char** argv) {
+    std::string input, output;
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help,h", "Show help")
+    ("input,i", po::value<std::string>(&input)->required(), "Set text user base (login:password per line)")
+    ("output,o", po::value<std::string>(&output)->required(), "Set compiled index file for the server --base option");
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help") || argc == 1) {
+            std::cout << desc << std::endl;
+            return 1;
+        }
+        po::notify(vm);
+    } catch (const po::error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::string, std::string>> users;
+    if (!UserBase::readText(input, users)) {
+        std::cerr << "Не удалось открыть базу: " << input << std::endl;
+        return 1;
+    }
+    std::vector<unsigned char> image = UserBase::compile(users);
+    if (image.empty()) {
+        std::cerr << "База слишком велика для индекса" << std::endl;
+        return 1;
+    }
+    if (!writeAtomically(output, image)) {
+        std::cerr << "Не удалось записать индекс: " << output << std::endl;
+        return 1;
+    }
+
+    // Проверка: каждый логин находится и дает пароль первого вхождения
+    UserBase base;
+    if (!base.load(output) || !base.compiled()) {
+        std::cerr << "Записанный индекс не прошел проверку: " << output << std::endl;
+        return 1;
+    }
+    std::unordered_map<std::string, const std::string*> expected;
+    for (const auto& user : users) {
+        expected.emplace(user.first, &user.second);
+    }
+    std::string password;
+    for (const auto& user : expected) {
+        if (!base.find(user.first, password) || password != *user.second) {
+            std::cerr << "Записанный индекс не прошел проверку для логина: " << user.first << std::endl;
+            return 1;
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Пользователей: " << base.size() << std::endl;
+    std::cout << "Пропущено повторов: " << users.size() - base.size() << std::endl;
+    std::cout << "Размер индекса: " << image.size() << " байт" << std::endl;
+    std::cout << "Время сборки: " << ms << " мс" << std::endl;
+    return 0;
+}
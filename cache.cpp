@@ -0,0 +1,118 @@
+/**
+ * @file cache.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация кэша результатов свертки
+ * @details Содержит поиск, вставку и вытеснение записей сегментированного LRU-кэша
+ */
+
+#include "cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/random.h>
+#include <system_error>
+
+/// Оценка памяти на одну запись: узел списка, узел и корзина хеш-таблицы
+static const size_t ENTRY_COST = sizeof(std::pair<CacheKey, CachedResult>) + 6 * sizeof(void*) + sizeof(Hash128);
+
+/**
+ * @struct CacheSecret
+ * @brief Секреты хешей ключа кэша
+ */
+struct CacheSecret {
+    uint64_t seed;      ///< Добавка к начальному значению MurmurHash3
+    uint64_t k0;        ///< Младшая половина ключа SipHash
+    uint64_t k1;        ///< Старшая половина ключа SipHash
+};
+
+/**
+ * @brief Секреты процесса
+ * @return Случайные значения, созданные при первом вызове
+ * @throw std::system_error, если getrandom не вернул нужное количество байт
+ */
+static const CacheSecret& cacheSecret() {
+    static const CacheSecret secret = []() {
+        CacheSecret value;
+        if (getrandom(&value, sizeof(value), 0) != static_cast<ssize_t>(sizeof(value))) {
+            throw std::system_error(errno, std::generic_category());
+        }
+        return value;
+    }();
+    return secret;
+}
+
+/**
+ * @brief Конструктор
+ * @param variant Вариант свертки (ядро, кодировка, размер вектора)
+ * @throw std::system_error, если не удалось получить случайный секрет
+ * @details Вариант добавляется и в начальное значение MurmurHash3, и в начало
+ * данных SipHash, поэтому одинаковые байты разных вариантов не совпадают
+ */
+CacheKeyHasher::CacheKeyHasher(uint64_t variant)
+    : murmur(variant ^ cacheSecret().seed), sip(cacheSecret().k0, cacheSecret().k1) {
+    sip.update(&variant, sizeof(variant));
+}
+
+/**
+ * @brief Конструктор
+ * @param memoryBudget Допустимый объем памяти под записи (байт)
+ */
+ResultCache::ResultCache(size_t memoryBudget)
+    : shards(new Shard[SHARDS]),
+      shardCapacity(std::max<size_t>(memoryBudget / ENTRY_COST / SHARDS, 1)) {
+    for (size_t i = 0; i < SHARDS; ++i) {
+        shards[i].index.reserve(shardCapacity);
+    }
+}
+
+/**
+ * @brief Поиск результата
+ * @param key Ключ вектора
+ * @param value Найденный результат (выходной параметр)
+ * @return true при попадании
+ */
+bool ResultCache::find(const CacheKey& key, CachedResult& value) {
+    Shard& s = shard(key.hash);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.index.find(key.hash);
+        // Совпадение одного MurmurHash3 может быть подобрано: нужен и проверочный хеш
+        if (it != s.index.end() && it->second->first == key) {
+            // Перемещаем запись в начало списка как самую свежую
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            value = it->second->second;
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Сохранение результата с вытеснением давно не использованных записей
+ * @param key Ключ вектора
+ * @param value Результат
+ */
+void ResultCache::insert(const CacheKey& key, const CachedResult& value) {
+    Shard& s = shard(key.hash);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.index.find(key.hash);
+    if (it != s.index.end()) {
+        // Запись с тем же hash заменяется целиком вместе с проверочным хешем
+        it->second->first = key;
+        it->second->second = value;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return;
+    }
+
+    if (s.index.size() >= shardCapacity) {
+        s.index.erase(s.lru.back().first.hash);
+        s.lru.pop_back();
+    }
+    s.lru.emplace_front(key, value);
+    s.index.emplace(key.hash, s.lru.begin());
+}
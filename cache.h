@@ -0,0 +1,170 @@
+/**
+ * @file cache.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для кэша результатов свертки
+ * @details Определяет класс ResultCache - ограниченный по памяти LRU-кэш,
+ * разделенный на независимые сегменты с собственными блокировками
+ */
+
+#pragma once
+#include "hash.h"
+#include "reduce.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @struct CachedResult
+ * @brief Сохраненный результат свертки
+ */
+struct CachedResult {
+    ReduceResult result;    ///< Результат в сетевом представлении
+    bool overflow;          ///< Было ли переполнение при свертке
+};
+
+/**
+ * @struct CacheKey
+ * @brief Ключ записи кэша
+ * @details Кэш общий для всех пользователей, поэтому одного MurmurHash3 мало:
+ * его коллизии строятся при любом начальном значении, и клиент мог бы
+ * подложить результат для чужого вектора. Запись находится по hash, а при
+ * попадании сравниваются длина и ключевой SipHash, который нельзя
+ * подобрать, не зная секрета процесса
+ */
+struct CacheKey {
+    Hash128 hash;       ///< MurmurHash3 вектора (выбирает запись)
+    uint64_t check;     ///< SipHash-2-4 вектора на секретном ключе процесса
+    uint64_t length;    ///< Длина хешированных данных (байт)
+
+    bool operator==(const CacheKey& other) const {
+        return hash == other.hash && check == other.check && length == other.length;
+    }
+};
+
+/**
+ * @class CacheKeyHasher
+ * @brief Потоковое вычисление ключа кэша
+ * @details Оба хеша считаются на случайных секретах, созданных один раз при
+ * первом использовании в процессе
+ */
+class CacheKeyHasher {
+public:
+    /**
+     * @brief Конструктор
+     * @param variant Вариант свертки (ядро, кодировка, размер вектора)
+     * @throw std::system_error, если не удалось получить случайный секрет
+     */
+    explicit CacheKeyHasher(uint64_t variant);
+
+    /**
+     * @brief Добавление очередной порции данных
+     * @param data Данные
+     * @param size Размер данных
+     */
+    void update(const void* data, size_t size) {
+        murmur.update(data, size);
+        sip.update(data, size);
+        length += size;
+    }
+
+    /**
+     * @brief Получение ключа
+     * @return Ключ всех добавленных данных
+     */
+    CacheKey key() const {
+        return CacheKey{murmur.digest(), sip.digest(), length};
+    }
+
+private:
+    Hasher128 murmur;       ///< Хеш для поиска записи
+    SipHasher sip;          ///< Проверочный хеш
+    uint64_t length = 0;    ///< Длина данных
+};
+
+/**
+ * @class ResultCache
+ * @brief Сегментированный LRU-кэш результатов по ключу вектора
+ * @details Ключ включает вариант свертки, размер и содержимое вектора.
+ * Сегмент выбирается по старшим битам хеша, поэтому потоки разных сессий
+ * конкурируют только при обращении к одному сегменту. Запись с тем же hash,
+ * но другими check или length считается промахом
+ */
+class ResultCache {
+public:
+    /**
+     * @brief Конструктор
+     * @param memoryBudget Допустимый объем памяти под записи (байт)
+     */
+    explicit ResultCache(size_t memoryBudget);
+
+    /**
+     * @brief Поиск результата
+     * @param key Ключ вектора
+     * @param value Найденный результат (выходной параметр)
+     * @return true при попадании
+     */
+    bool find(const CacheKey& key, CachedResult& value);
+
+    /**
+     * @brief Сохранение результата с вытеснением давно не использованных записей
+     * @param key Ключ вектора
+     * @param value Результат
+     */
+    void insert(const CacheKey& key, const CachedResult& value);
+
+    /**
+     * @brief Количество попаданий
+     * @return Счетчик попаданий
+     */
+    uint64_t hits() const {
+        return hitCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Количество промахов
+     * @return Счетчик промахов
+     */
+    uint64_t misses() const {
+        return missCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Хеш-функция для unordered_map (ключ уже равномерно распределен)
+     */
+    struct KeyHash {
+        size_t operator()(const Hash128& key) const {
+            return static_cast<size_t>(key.lo);
+        }
+    };
+
+    /**
+     * @brief Сегмент кэша
+     */
+    struct Shard {
+        std::mutex mutex;                                       ///< Блокировка сегмента
+        std::list<std::pair<CacheKey, CachedResult>> lru;       ///< Записи от новых к старым
+        std::unordered_map<Hash128, std::list<std::pair<CacheKey, CachedResult>>::iterator, KeyHash> index; ///< Поиск записи
+    };
+
+    static const size_t SHARDS = 16;    ///< Количество сегментов
+
+    /**
+     * @brief Сегмент для ключа
+     * @param key Хеш вектора
+     * @return Сегмент
+     */
+    Shard& shard(const Hash128& key) {
+        return shards[key.hi >> 60];
+    }
+
+    std::unique_ptr<Shard[]> shards;            ///< Сегменты
+    size_t shardCapacity;                       ///< Максимум записей в сегменте
+    std::atomic<uint64_t> hitCount{0};          ///< Счетчик попаданий
+    std::atomic<uint64_t> missCount{0};         ///< Счетчик промахов
+};
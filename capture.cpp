@@ -0,0 +1,261 @@
+/**
+ * @file capture.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация захвата входящего трафика сессий
+ * @details Записи копируются в общий буфер под блокировкой и сбрасываются
+ * в файл крупными блоками; время записи берется под той же блокировкой,
+ * поэтому интервалы между записями не отрицательны
+ */
+
+#include "capture.h"
+#include "codec.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unistd.h>
+
+std::atomic<bool> captureRecording(false);
+
+static const size_t CAPTURE_FLUSH_SIZE = 1 << 20;       ///< Размер буфера перед сбросом в файл
+static std::mutex captureMutex;                         ///< Защита файла, буфера и списка сессий
+static FILE* captureFile = nullptr;                     ///< Файл захвата
+static std::vector<unsigned char> captureBuffer;        ///< Записи, еще не сброшенные в файл
+static std::map<int, uint64_t> captureSessions;         ///< Сессии захвата по сокетам
+static std::chrono::steady_clock::time_point captureLast; ///< Время предыдущей записи
+static long captureCount = 0;                           ///< Количество записей
+
+/**
+ * @brief Сброс буфера в файл
+ * @details Вызывается под captureMutex
+ */
+static void captureFlush() {
+    if (!captureBuffer.empty()) {
+        fwrite(captureBuffer.data(), 1, captureBuffer.size(), captureFile);
+        captureBuffer.clear();
+    }
+}
+
+/**
+ * @brief Добавление записи в буфер
+ * @param session Идентификатор сессии
+ * @param kind Вид записи
+ * @param data Данные или nullptr
+ * @param size Размер данных или ответа
+ * @details Вызывается под captureMutex
+ */
+static void captureAppend(uint64_t session, CaptureKind kind, const void* data, size_t size) {
+    auto now = std::chrono::steady_clock::now();
+    captureBuffer.push_back(static_cast<unsigned char>(kind));
+    writeVarint(captureBuffer, session);
+    writeVarint(captureBuffer, std::chrono::duration_cast<std::chrono::nanoseconds>(now - captureLast).count());
+    writeVarint(captureBuffer, size);
+    if (data != nullptr) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        captureBuffer.insert(captureBuffer.end(), bytes, bytes + size);
+    }
+    captureLast = now;
+    ++captureCount;
+    if (captureBuffer.size() >= CAPTURE_FLUSH_SIZE) {
+        captureFlush();
+    }
+}
+
+/**
+ * @brief Открытие файла захвата и включение записи
+ * @param path Имя файла
+ * @return false, если файл не открылся или уже существует
+ * @details Захват содержит хеши аутентификации, поэтому файл создается
+ * заново с правами 0600; существующий файл (в том числе ссылка) не
+ * перезаписывается
+ */
+bool captureStart(const std::string& path) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    captureFile = fdopen(fd, "wb");
+    if (captureFile == nullptr) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+    fwrite(CAPTURE_MAGIC, 1, 8, captureFile);
+    captureBuffer.reserve(CAPTURE_FLUSH_SIZE + 64 * 1024);
+    captureLast = std::chrono::steady_clock::now();
+    captureCount = 0;
+    captureRecording.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Приветствие без значения билета возобновления
+ * @param data Приветствие
+ * @param size Размер приветствия
+ * @return Приветствие, в котором значение "ticket=" заменено на "*"
+ * @details Билет - предъявительский токен: по нему можно возобновить
+ * сессию без пароля, поэтому в файл захвата он не попадает
+ */
+static std::string redactHello(const void* data, size_t size) {
+    std::string hello(static_cast<const char*>(data), size);
+    size_t colon = hello.find(':');
+    if (colon == std::string::npos) {
+        return hello;
+    }
+    for (size_t item = colon + 1; item < hello.size(); ) {
+        size_t next = hello.find(',', item);
+        size_t itemEnd = next == std::string::npos ? hello.size() : next;
+        if (hello.compare(item, 7, "ticket=") == 0 && itemEnd > item + 7) {
+            hello.replace(item + 7, itemEnd - item - 7, "*");
+            itemEnd = item + 8;
+        }
+        item = itemEnd + 1;
+    }
+    return hello;
+}
+
+/**
+ * @brief Сохранение записи сессии, связанной с сокетом
+ * @param socket Сокет сессии
+ * @param kind Вид записи
+ * @param data Данные (nullptr для CaptureKind::Result)
+ * @param size Размер данных
+ */
+void captureRecord(int socket, CaptureKind kind, const void* data, size_t size) {
+    std::string redacted;
+    if (kind == CaptureKind::Hello) {
+        redacted = redactHello(data, size);
+        data = redacted.data();
+        size = redacted.size();
+    }
+    std::lock_guard<std::mutex> lock(captureMutex);
+    auto it = captureSessions.find(socket);
+    if (captureFile == nullptr || it == captureSessions.end()) {
+        return;
+    }
+    captureAppend(it->second, kind, data, size);
+}
+
+/**
+ * @brief Выключение записи и закрытие файла захвата
+ * @return Количество записанных записей или -1, если захват не велся
+ */
+long captureStop() {
+    captureRecording.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (captureFile == nullptr) {
+        return -1;
+    }
+    captureFlush();
+    fclose(captureFile);
+    captureFile = nullptr;
+    captureSessions.clear();
+    return captureCount;
+}
+
+/**
+ * @brief Начало сессии
+ * @param socket Сокет сессии
+ * @param session Идентификатор сессии
+ */
+CaptureSession::CaptureSession(int socket, uint64_t session)
+    : socket(socket), active(captureRecording.load(std::memory_order_relaxed)) {
+    if (active) {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        if (captureFile != nullptr) {
+            captureSessions[socket] = session;
+            captureAppend(session, CaptureKind::Begin, nullptr, 0);
+        }
+    }
+}
+
+/**
+ * @brief Конец сессии
+ */
+CaptureSession::~CaptureSession() {
+    if (active) {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        auto it = captureSessions.find(socket);
+        if (captureFile != nullptr && it != captureSessions.end()) {
+            captureAppend(it->second, CaptureKind::End, nullptr, 0);
+            captureSessions.erase(it);
+        }
+    }
+}
+
+/**
+ * @brief Чтение файла захвата
+ * @param path Имя файла
+ * @param sessions Сессии в порядке начала (выходной параметр)
+ * @param truncated Была ли отброшена незавершенная последняя запись
+ * (выходной параметр, nullptr - не сообщать)
+ * @return false, если файл не открылся, не является захватом или
+ * поврежден; также false при незавершенной записи, если truncated равен nullptr
+ */
+bool captureLoad(const std::string& path, std::vector<CapturedSession>& sessions, bool* truncated) {
+    if (truncated != nullptr) {
+        *truncated = false;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (contents.size() < 8 || std::memcmp(contents.data(), CAPTURE_MAGIC, 8) != 0) {
+        return false;
+    }
+
+    const unsigned char* pos = reinterpret_cast<const unsigned char*>(contents.data()) + 8;
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(contents.data()) + contents.size();
+    std::map<uint64_t, size_t> index;
+    int64_t now = 0;
+    sessions.clear();
+
+    while (pos < end) {
+        uint8_t kind = *pos++;
+        if (kind > static_cast<uint8_t>(CaptureKind::End)) {
+            return false;
+        }
+        uint64_t session, delta, size;
+        if (!readVarint(pos, end, session) || !readVarint(pos, end, delta) || !readVarint(pos, end, size)) {
+            // Чтение дошло до конца файла - запись не дописана, иначе значение испорчено
+            if (pos != end || truncated == nullptr) {
+                return false;
+            }
+            *truncated = true;
+            break;
+        }
+        bool hasData = kind != static_cast<uint8_t>(CaptureKind::Result);
+        if (hasData && size > static_cast<uint64_t>(end - pos)) {
+            if (truncated == nullptr) {
+                return false;
+            }
+            *truncated = true;
+            break;
+        }
+        now += static_cast<int64_t>(delta);
+
+        auto it = index.find(session);
+        if (it == index.end()) {
+            it = index.emplace(session, sessions.size()).first;
+            sessions.push_back(CapturedSession{session, now, {}});
+        }
+        CapturedSession& s = sessions[it->second];
+        CapturedRecord record{static_cast<CaptureKind>(kind), now - s.startNs, static_cast<size_t>(size), std::string()};
+        if (hasData) {
+            record.data.assign(reinterpret_cast<const char*>(pos), static_cast<size_t>(size));
+            pos += size;
+        }
+        s.records.push_back(std::move(record));
+    }
+    return true;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file capture.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для захвата входящего трафика сессий
+ * @details Определяет формат файла захвата и функции записи и чтения.
+ * Файл начинается с CAPTURE_MAGIC, далее идут записи:
+ * - вид записи (1 байт, CaptureKind);
+ * - идентификатор сессии (LEB128);
+ * - время от предыдущей записи файла в наносекундах (LEB128);
+ * - размер (LEB128);
+ * - данные указанного размера (кроме CaptureKind::Result, где размер -
+ *   длина ответа сервера, а данные не сохраняются).
+ *
+ * Записываются входящие данные сессии в порядке протокола на сокете
+ * (приветствие, хеш, количества, размеры, элементы) и размеры результатов.
+ * Значение билета возобновления в приветствии заменяется на "*".
+ * Обмен через разделяемую память записывается в том же виде, что и через сокет
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CAPTURE_MAGIC "SRVCAP1\n"   ///< Заголовок файла захвата (8 байт)
+
+/**
+ * @enum CaptureKind
+ * @brief Вид записи захвата
+ */
+enum class CaptureKind : uint8_t {
+    Begin,      ///< Начало сессии
+    Hello,      ///< Приветствие клиента
+    Hash,       ///< Хеш пароля клиента
+    Data,       ///< Данные после аутентификации
+    Result,     ///< Ответ сервера на вектор (только размер)
+    End         ///< Конец сессии
+};
+
+/// Включена ли запись захвата
+extern std::atomic<bool> captureRecording;
+
+/**
+ * @brief Открытие файла захвата и включение записи
+ * @param path Имя файла
+ * @return false, если файл не открылся или уже существует
+ * @details Файл создается заново с правами 0600
+ */
+bool captureStart(const std::string& path);
+
+/**
+ * @brief Сохранение записи сессии, связанной с сокетом
+ * @param socket Сокет сессии
+ * @param kind Вид записи
+ * @param data Данные (nullptr для CaptureKind::Result)
+ * @param size Размер данных
+ * @details Сокеты без открытой сессии захвата пропускаются
+ */
+void captureRecord(int socket, CaptureKind kind, const void* data, size_t size);
+
+/**
+ * @brief Сохранение входящих данных, если запись включена
+ * @param socket Сокет сессии
+ * @param kind Вид записи
+ * @param data Данные
+ * @param size Размер данных
+ */
+inline void captureInbound(int socket, CaptureKind kind, const void* data, size_t size) {
+    if (captureRecording.load(std::memory_order_relaxed)) {
+        captureRecord(socket, kind, data, size);
+    }
+}
+
+/**
+ * @brief Сохранение размера ответа, если запись включена
+ * @param socket Сокет сессии
+ * @param size Размер ответа
+ */
+inline void captureResult(int socket, size_t size) {
+    if (captureRecording.load(std::memory_order_relaxed)) {
+        captureRecord(socket, CaptureKind::Result, nullptr, size);
+    }
+}
+
+/**
+ * @brief Выключение записи и закрытие файла захвата
+ * @return Количество записанных записей или -1, если захват не велся
+ */
+long captureStop();
+
+/**
+ * @class CaptureSession
+ * @brief Сессия захвата на время жизни объекта
+ * @details Связывает сокет с идентификатором сессии и записывает начало и
+ * конец сессии. Сокет должен оставаться открытым до разрушения объекта
+ */
+class CaptureSession {
+public:
+    /**
+     * @brief Начало сессии
+     * @param socket Сокет сессии
+     * @param session Идентификатор сессии
+     */
+    CaptureSession(int socket, uint64_t session);
+
+    /**
+     * @brief Конец сессии
+     */
+    ~CaptureSession();
+
+    CaptureSession(const CaptureSession&) = delete;
+    CaptureSession& operator=(const CaptureSession&) = delete;
+
+private:
+    int socket;     ///< Сокет сессии
+    bool active;    ///< Велся ли захват при начале сессии
+};
+
+/**
+ * @struct CapturedRecord
+ * @brief Запись захвата, прочитанная из файла
+ */
+struct CapturedRecord {
+    CaptureKind kind;   ///< Вид записи
+    int64_t timeNs;     ///< Время от начала сессии (нс)
+    size_t size;        ///< Размер данных или ответа
+    std::string data;   ///< Данные (пусто для CaptureKind::Result)
+};
+
+/**
+ * @struct CapturedSession
+ * @brief Сессия захвата, прочитанная из файла
+ */
+struct CapturedSession {
+    uint64_t id;                            ///< Идентификатор сессии
+    int64_t startNs;                        ///< Начало сессии от начала захвата (нс)
+    std::vector<CapturedRecord> records;    ///< Записи сессии по порядку
+};
+
+/**
+ * @brief Чтение файла захвата
+ * @param path Имя файла
+ * @param sessions Сессии в порядке начала (выходной параметр)
+ * @param truncated Была ли отброшена незавершенная последняя запись
+ * (выходной параметр, nullptr - не сообщать)
+ * @return false, если файл не открылся, не является захватом или
+ * поврежден; также false при незавершенной записи, если truncated равен nullptr
+ * @details Незавершенная последняя запись (сервер остановлен аварийно)
+ * отбрасывается, и вызывающий, передавший truncated, узнает об этом из
+ * него; записи до нее остаются в sessions
+ */
+bool captureLoad(const std::string& path, std::vector<CapturedSession>& sessions, bool* truncated = nullptr);
@@ -0,0 +1,306 @@
+/**
+ * @file codec.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация сжатых кодировок элементов вектора
+ * @details Декодер разбирает LEB128 блоками и подает элементы в ядро свертки,
+ * не восстанавливая вектор целиком. Восемь подряд идущих однобайтовых
+ * значений распознаются одной проверкой 64-битного слова
+ */
+
+#include "codec.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+/// Количество элементов, декодируемых перед вызовом kernel.feed
+static const size_t DECODE_BLOCK = 1024;
+
+/// Старшие биты всех байтов 64-битного слова
+static const uint64_t CONTINUATION_BITS = 0x8080808080808080ull;
+
+/**
+ * @brief Отображение знаковой разности в беззнаковое число (zigzag)
+ * @param value Знаковое значение
+ * @return Значение, малое по модулю для малых |value|
+ */
+static inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @brief Обратное преобразование zigzag
+ * @param value Закодированное значение
+ * @return Знаковое значение в представлении uint64_t
+ */
+static inline uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+/**
+ * @brief Преобразования элемента для кодирования
+ * @tparam T Тип элементов
+ * @details Элемент расширяется до uint64_t (знаковые - с расширением знака),
+ * поэтому разности считаются по модулю 2^64 одинаково для всех типов
+ */
+template <typename T>
+struct ElemCodec {
+    /// Знаковые значения передаются в zigzag
+    static constexpr bool SIGNED = std::numeric_limits<T>::is_signed;
+
+    /// Расширение элемента до 64 бит
+    static inline uint64_t widen(T x) {
+        return static_cast<uint64_t>(static_cast<int64_t>(x));
+    }
+
+    /// Сужение до типа элемента с проверкой диапазона
+    static inline bool narrow(uint64_t w, T& out) {
+        out = static_cast<T>(w);
+        return widen(out) == w;
+    }
+
+    /// Значение для varint и rle
+    static inline uint64_t toVarint(T x) {
+        return SIGNED ? zigzag(static_cast<int64_t>(widen(x))) : widen(x);
+    }
+
+    /// Элемент из значения varint и rle
+    static inline bool fromVarint(uint64_t v, T& out) {
+        return narrow(SIGNED ? unzigzag(v) : v, out);
+    }
+};
+
+/**
+ * @brief Декодирование и свертка вектора с элементами типа T
+ * @tparam T Тип элементов
+ * @param kernel Ядро свертки
+ * @param encoding Сжатая кодировка
+ * @param pos Начало закодированных данных
+ * @param end Конец закодированных данных
+ * @param count Ожидаемое количество элементов
+ * @param state Состояние свертки
+ * @return false, если данные повреждены
+ */
+template <typename T>
+static bool decodeTyped(const ReduceKernel& kernel, PayloadEncoding encoding, const unsigned char* pos,
+                        const unsigned char* end, uint32_t count, ReduceState& state) {
+    using Codec = ElemCodec<T>;
+    T block[DECODE_BLOCK];
+    size_t filled = 0;
+    uint64_t remaining = count;
+
+    if (encoding == PayloadEncoding::Rle) {
+        while (remaining > 0) {
+            uint64_t run, v;
+            T value;
+            if (!readVarint(pos, end, run) || !readVarint(pos, end, v)
+                || run == 0 || run > remaining || !Codec::fromVarint(v, value)) {
+                return false;
+            }
+            remaining -= run;
+            while (run > 0) {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(run, DECODE_BLOCK - filled));
+                std::fill_n(block + filled, n, value);
+                filled += n;
+                run -= n;
+                if (filled == DECODE_BLOCK) {
+                    kernel.feed(state, block, filled);
+                    filled = 0;
+                }
+            }
+        }
+    } else {
+        const bool delta = encoding == PayloadEncoding::Delta;
+        uint64_t prev = 0;
+        bool ok = true;
+        // Одно значение LEB128 в элемент; для delta - с накоплением суммы
+        auto put = [&](uint64_t v) {
+            T value;
+            if (delta) {
+                prev += unzigzag(v);
+                ok &= Codec::narrow(prev, value);
+            } else {
+                ok &= Codec::fromVarint(v, value);
+            }
+            block[filled++] = value;
+        };
+
+        while (remaining > 0) {
+            // Быстрый путь: восемь однобайтовых значений подряд
+            uint64_t word;
+            if (remaining >= 8 && DECODE_BLOCK - filled >= 8 && end - pos >= 8
+                && (std::memcpy(&word, pos, sizeof(word)), (word & CONTINUATION_BITS) == 0)) {
+                for (int i = 0; i < 8; ++i) {
+                    put(pos[i]);
+                }
+                pos += 8;
+                remaining -= 8;
+            } else {
+                uint64_t v;
+                if (!readVarint(pos, end, v)) {
+                    return false;
+                }
+                put(v);
+                --remaining;
+            }
+            if (filled == DECODE_BLOCK) {
+                kernel.feed(state, block, filled);
+                filled = 0;
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    kernel.feed(state, block, filled);
+    return pos == end;
+}
+
+/**
+ * @brief Кодирование вектора с элементами типа T
+ * @tparam T Тип элементов
+ * @param encoding Сжатая кодировка
+ * @param elems Элементы
+ * @param count Количество элементов
+ * @return Закодированные данные
+ */
+template <typename T>
+static std::vector<unsigned char> encodeTyped(PayloadEncoding encoding, const T* elems, uint32_t count) {
+    using Codec = ElemCodec<T>;
+    std::vector<unsigned char> out;
+    out.reserve(count);
+
+    if (encoding == PayloadEncoding::Rle) {
+        for (uint32_t i = 0; i < count; ) {
+            uint32_t run = 1;
+            while (i + run < count && elems[i + run] == elems[i]) {
+                ++run;
+            }
+            writeVarint(out, run);
+            writeVarint(out, Codec::toVarint(elems[i]));
+            i += run;
+        }
+    } else if (encoding == PayloadEncoding::Delta) {
+        uint64_t prev = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t cur = Codec::widen(elems[i]);
+            writeVarint(out, zigzag(static_cast<int64_t>(cur - prev)));
+            prev = cur;
+        }
+    } else {
+        for (uint32_t i = 0; i < count; ++i) {
+            writeVarint(out, Codec::toVarint(elems[i]));
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Выбор кодировки по имени из рукопожатия
+ * @param name Имя: raw, varint, delta, rle
+ * @param kernel Ядро свертки сессии
+ * @param encoding Кодировка (выходной параметр)
+ * @return false, если имя не распознано или кодировка неприменима к типу элементов
+ */
+bool selectEncoding(const std::string& name, const ReduceKernel& kernel, PayloadEncoding& encoding) {
+    static const char* const names[] = {"raw", "varint", "delta", "rle"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (name == names[i]) {
+            encoding = static_cast<PayloadEncoding>(i);
+            bool integer = kernel.type == ElemType::U16 || kernel.type == ElemType::I32 || kernel.type == ElemType::U64;
+            return encoding == PayloadEncoding::Raw || integer;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Наибольший допустимый размер закодированного вектора
+ * @param kernel Ядро свертки
+ * @param encoding Кодировка
+ * @param count Количество элементов
+ * @return Размер в байтах
+ */
+size_t maxEncodedSize(const ReduceKernel& kernel, PayloadEncoding encoding, uint32_t count) {
+    // Самое длинное значение LEB128 для элемента (разность uint16_t занимает 17 бит)
+    size_t longest = kernel.elemSize == 2 ? 3 : kernel.elemSize == 4 ? 5 : 10;
+    switch (encoding) {
+        case PayloadEncoding::Raw:
+            return static_cast<size_t>(count) * kernel.elemSize;
+        case PayloadEncoding::Rle:
+            return static_cast<size_t>(count) * (5 + longest);
+        default:
+            return static_cast<size_t>(count) * longest;
+    }
+}
+
+/**
+ * @brief Кодирование элементов вектора
+ * @param kernel Ядро свертки (определяет тип элементов)
+ * @param encoding Кодировка
+ * @param data Элементы в исходном представлении
+ * @param count Количество элементов
+ * @return Закодированные данные
+ */
+std::vector<unsigned char> encodePayload(const ReduceKernel& kernel, PayloadEncoding encoding,
+                                         const void* data, uint32_t count) {
+    if (encoding == PayloadEncoding::Raw) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        return std::vector<unsigned char>(bytes, bytes + static_cast<size_t>(count) * kernel.elemSize);
+    }
+    switch (kernel.type) {
+        case ElemType::U16:
+            return encodeTyped(encoding, static_cast<const uint16_t*>(data), count);
+        case ElemType::I32:
+            return encodeTyped(encoding, static_cast<const int32_t*>(data), count);
+        case ElemType::U64:
+            return encodeTyped(encoding, static_cast<const uint64_t*>(data), count);
+        default:
+            return std::vector<unsigned char>();
+    }
+}
+
+/**
+ * @brief Свертка закодированного вектора без восстановления его целиком
+ * @param kernel Ядро свертки
+ * @param encoding Сжатая кодировка
+ * @param data Закодированные данные
+ * @param size Размер закодированных данных
+ * @param count Ожидаемое количество элементов
+ * @param result Результат (выходной параметр)
+ * @param overflow Было ли переполнение при свертке (выходной параметр)
+ * @return false, если данные повреждены
+ */
+bool decodeReduce(const ReduceKernel& kernel, PayloadEncoding encoding, const unsigned char* data, size_t size,
+                  uint32_t count, ReduceResult& result, bool& overflow) {
+    if (encoding == PayloadEncoding::Raw) {
+        return false;
+    }
+    ReduceState state;
+    kernel.init(state);
+
+    bool ok;
+    switch (kernel.type) {
+        case ElemType::U16:
+            ok = decodeTyped<uint16_t>(kernel, encoding, data, data + size, count, state);
+            break;
+        case ElemType::I32:
+            ok = decodeTyped<int32_t>(kernel, encoding, data, data + size, count, state);
+            break;
+        case ElemType::U64:
+            ok = decodeTyped<uint64_t>(kernel, encoding, data, data + size, count, state);
+            break;
+        default:
+            ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    result.size = kernel.resultSize;
+    overflow = kernel.finish(state, result.bytes);
+    return true;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file codec.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для сжатых кодировок элементов вектора
+ * @details Определяет кодировки, согласуемые параметром "enc" в приветствии:
+ * - raw: элементы в исходном представлении (по умолчанию);
+ * - varint: каждый элемент в LEB128;
+ * - delta: разность с предыдущим элементом в zigzag + LEB128;
+ * - rle: пары "длина серии, значение" в LEB128.
+ *
+ * Для int32 значения в varint и rle передаются в zigzag. Сжатые кодировки
+ * определены только для целочисленных типов. В сжатой кодировке за размером
+ * вектора (uint32_t, количество элементов) следует размер закодированных
+ * данных в байтах (uint32_t) и сами данные
+ */
+
+#pragma once
+#include "reduce.h"
+#include <string>
+#include <vector>
+
+/**
+ * @enum PayloadEncoding
+ * @brief Кодировка элементов вектора
+ */
+enum class PayloadEncoding {
+    Raw,        ///< Исходное представление
+    Varint,     ///< LEB128
+    Delta,      ///< Разности zigzag + LEB128
+    Rle         ///< Серии одинаковых значений
+};
+
+/**
+ * @brief Чтение одного значения LEB128
+ * @param pos Текущая позиция (сдвигается за прочитанное значение)
+ * @param end Конец данных
+ * @param value Значение (выходной параметр)
+ * @return false, если данные закончились или значение длиннее 64 бит
+ */
+inline bool readVarint(const unsigned char*& pos, const unsigned char* end, uint64_t& value) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; pos < end && shift < 64; shift += 7) {
+        unsigned char byte = *pos++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Запись одного значения LEB128
+ * @param out Выходной буфер
+ * @param value Значение
+ */
+inline void writeVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+/**
+ * @brief Выбор кодировки по имени из рукопожатия
+ * @param name Имя: raw, varint, delta, rle
+ * @param kernel Ядро свертки сессии
+ * @param encoding Кодировка (выходной параметр)
+ * @return false, если имя не распознано или кодировка неприменима к типу элементов
+ */
+bool selectEncoding(const std::string& name, const ReduceKernel& kernel, PayloadEncoding& encoding);
+
+/**
+ * @brief Наибольший допустимый размер закодированного вектора
+ * @param kernel Ядро свертки
+ * @param encoding Кодировка
+ * @param count Количество элементов
+ * @return Размер в байтах
+ */
+size_t maxEncodedSize(const ReduceKernel& kernel, PayloadEncoding encoding, uint32_t count);
+
+/**
+ * @brief Кодирование элементов вектора
+ * @param kernel Ядро свертки (определяет тип элементов)
+ * @param encoding Кодировка
+ * @param data Элементы в исходном представлении
+ * @param count Количество элементов
+ * @return Закодированные данные
+ */
+std::vector<unsigned char> encodePayload(const ReduceKernel& kernel, PayloadEncoding encoding,
+                                         const void* data, uint32_t count);
+
+/**
+ * @brief Свертка закодированного вектора без восстановления его целиком
+ * @param kernel Ядро свертки
+ * @param encoding Сжатая кодировка
+ * @param data Закодированные данные
+ * @param size Размер закодированных данных
+ * @param count Ожидаемое количество элементов
+ * @param result Результат (выходной параметр)
+ * @param overflow Было ли переполнение при свертке (выходной параметр)
+ * @return false, если данные повреждены: значение не помещается в тип,
+ * количество элементов не совпадает или остались лишние байты
+ * @details Элементы декодируются блоками в буфер на стеке и сразу подаются
+ * в kernel.feed
+ */
+bool decodeReduce(const ReduceKernel& kernel, PayloadEncoding encoding, const unsigned char* data, size_t size,
+                  uint32_t count, ReduceResult& result, bool& overflow);
@@ -9,10 +9,45 @@
  */
 
 #include "connection.h"
+#include "handoff.h"
 #include "log.h"
+#include "cache.h"
+#include "capture.h"
+#include "codec.h"
+#include "shm.h"
+#include "supervisor.h"
+#include "threadpool.h"
+#include "tls.h"
+#include "trace.h"
+#include "userbase.h"
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <fcntl.h>
+#include <map>
+#include <netinet/tcp.h>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <cstddef>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+static std::atomic<bool> stopRequested(false); ///< Флаг плавной остановки сервера
+static int wakePipe[2] = {-1, -1};             ///< Канал для пробуждения цикла приема соединений
+static std::mutex sessionsMutex;               ///< Защита множества активных сессий
+static std::condition_variable sessionsDone;   ///< Сигнал о завершении сессии
+static std::set<int> activeSessions;           ///< Сокеты активных сессий
+static int inheritedListener = -1;             ///< Слушающий сокет рабочего процесса, полученный от супервизора
+static std::unique_ptr<TlsContext> serverTls;  ///< Контекст TLS (nullptr - соединения без шифрования)
 
 /**
  * @brief Поиск пользователя в файле по логину с кэшированием
@@ -21,54 +56,27 @@
  * @param password Найденный пароль (выходной параметр)
  * @return true если пользователь найден, false если нет
  * @warning Файл пользователей загружается только при первом вызове
+ * @details Файл может быть текстовой базой или индексом, собранным basec;
+ * индекс отображается в память без разбора. База хранится в разделяемой
+ * области только для чтения; рабочие процессы наследуют уже загруженную
+ * базу от супервизора. После загрузки поиск выполняется без блокировки
  */
 bool findUserInFile(const std::string& filename, const std::string& username, std::string& password) {
-    static std::vector<std::pair<std::string, std::string>> userCache;
-    static bool cacheLoaded = false;
-    
-    // Загружаем кэш при первом вызове
-    if (!cacheLoaded) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            return false;
-        }
-        
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.empty() || line[0] == '#' || line[0] == ';') {
-                continue;
-            }
-            
-            size_t pos = line.find(':');
-            if (pos == std::string::npos) {
-                continue;
+    static UserBase userBase;
+    static std::atomic<bool> baseLoaded(false);
+    static std::mutex loadMutex;
+
+    // Загружаем базу при первом вызове
+    if (!baseLoaded.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        if (!baseLoaded.load(std::memory_order_relaxed)) {
+            if (!userBase.load(filename)) {
+                return false;
             }
-            
-            std::string file_user = line.substr(0, pos);
-            std::string file_pass = line.substr(pos + 1);
-            
-            // Убираем пробелы
-            file_user.erase(0, file_user.find_first_not_of(" \t"));
-            file_user.erase(file_user.find_last_not_of(" \t") + 1);
-            file_pass.erase(0, file_pass.find_first_not_of(" \t"));
-            file_pass.erase(file_pass.find_last_not_of(" \t") + 1);
-            
-            userCache.emplace_back(file_user, file_pass);
-        }
-        cacheLoaded = true;
-        file.close();
-    }
-    
-    // Ищем в кэше
-    auto it = std::find_if(userCache.begin(), userCache.end(),
-        [&username](const auto& pair) { return pair.first == username; });
-    
-    if (it != userCache.end()) {
-        password = it->second;
-        return true;
+            baseLoaded.store(true, std::memory_order_release);
+        }
     }
-    
-    return false;
+    return userBase.find(username, password);
 }
 
 /**
@@ -93,53 +101,74 @@ std::string generateSalt(size_t length = 16) {
 }
 
 /**
- * @brief Обработка одного вектора с проверкой на переполнение
+ * @brief Время активного ожидания перед блокировкой
+ * @param p Параметры соединения
+ * @return LOW_LATENCY_SPIN_US в профиле низкой задержки или 0
+ * @details На единственном процессоре активное ожидание только отнимает
+ * время у потока, который должен подготовить данные, поэтому отключается.
+ * По умолчанию LOW_LATENCY_SPIN_US равен 0 (см. connection.h)
+ */
+static int spinMicros(const Params* p) {
+    static const bool multicore = std::thread::hardware_concurrency() > 1;
+    return p->lowLatency && multicore ? LOW_LATENCY_SPIN_US : 0;
+}
+
+/**
+ * @brief Настройка сокета клиента для профиля низкой задержки
  * @param client_socket Сокет клиента
- * @param vector_size Размер вектора
  * @param p Параметры соединения
- * @return Результат обработки вектора (произведение элементов)
- * @throw std::system_error при ошибках сетевых операций
- * @warning Проверяет переполнение и ограничивает размер вектора
+ * @details Для TCP отключает алгоритм Нейгла (результат в 4 байта уходит
+ * сразу) и отложенное подтверждение на время рукопожатия. TCP_QUICKACK не
+ * включается заново после каждого recv: это отправляет отдельный пакет
+ * подтверждения, которое иначе уходит вместе с результатом вектора.
+ * SO_BUSY_POLL заставляет ядро при ожидании данных опрашивать очередь
+ * сетевой карты вместо ожидания прерывания; значение выше
+ * net.core.busy_read требует CAP_NET_ADMIN, поэтому отказ журналируется
+ * один раз. Как и активное ожидание в процессе, опрос в ядре включается
+ * только на нескольких процессорах
  */
-uint32_t processVector(int client_socket, uint32_t vector_size, const Params* p) {
-    if (vector_size == 0) {
-        return 1; // Произведение пустого вектора = 1
+static void tuneSocket(int client_socket, const Params* p) {
+    if (!p->lowLatency || p->addressFamily == AF_UNIX) {
+        return;
     }
-    
-    if (vector_size > 10000) { // Защита от слишком больших векторов
-        std::string errorMsg = "Слишком большой размер вектора: " + std::to_string(vector_size);
-        logError(p->logFile, errorMsg);
-        return 0;
+    int one = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(client_socket, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#ifdef SO_BUSY_POLL
+    static std::atomic<bool> busyPollReported(false);
+    int busy_poll = LOW_LATENCY_BUSY_POLL_US;
+    if (spinMicros(p) > 0 && setsockopt(client_socket, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == -1
+        && !busyPollReported.exchange(true)) {
+        logError(p->logFile, "SO_BUSY_POLL недоступен: " + std::string(strerror(errno)));
     }
-    
-    uint64_t result = 1; // Используем 64-бит для предотвращения переполнения
-    
-    for (uint32_t elem_idx = 0; elem_idx < vector_size; elem_idx++) {
-        uint16_t element;
-        ssize_t total_received = 0;
-        char* buff = reinterpret_cast<char*>(&element);
-        
-        while (total_received < sizeof(element)) {
-            ssize_t received = recv(client_socket, buff + total_received, 
-                                   sizeof(element) - total_received, 0);
-            if (received <= 0) {
-                std::string errorMsg = "Ошибка recv (элемент вектора): " + std::string(strerror(errno));
-                logError(p->logFile, errorMsg);
-                throw std::system_error(errno, std::generic_category());
-            }
-            total_received += received;
-        }
-        
-        // Проверка на переполнение
-        if (element != 0 && result > UINT32_MAX / element) {
-            logError(p->logFile, "Обнаружено переполнение при умножении вектора");
-            return UINT32_MAX; // Максимальное значение при переполнении
-        }
-        
-        result *= element;
+#endif
+}
+
+/**
+ * @brief Получение данных с активным ожиданием перед блокировкой
+ * @param socket Сокет
+ * @param buffer Буфер
+ * @param size Размер буфера
+ * @param p Параметры соединения
+ * @return Результат как у recv()
+ * @details В течение spinMicros() данные читаются без блокировки,
+ * что избавляет от пробуждения потока, если следующий вектор уже в пути;
+ * затем поток блокируется в обычном recv
+ */
+static ssize_t spinRecv(int socket, void* buffer, size_t size, const Params* p) {
+    ssize_t received = -1;
+    errno = EAGAIN;
+    if (int spin = spinMicros(p)) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin);
+        do {
+            received = recv(socket, buffer, size, MSG_DONTWAIT);
+        } while (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                 && std::chrono::steady_clock::now() < deadline);
     }
-    
-    return static_cast<uint32_t>(std::min(result, static_cast<uint64_t>(UINT32_MAX)));
+    if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        received = recv(socket, buffer, size, 0);
+    }
+    return received;
 }
 
 /**
@@ -156,7 +185,8 @@ void safeRecv(int socket, void* buffer, size_t size, const Params* p, const std:
     char* buff = reinterpret_cast<char*>(buffer);
     
     while (total_received < size) {
-        ssize_t received = recv(socket, buff + total_received, size - total_received, 0);
+        ssize_t received = p->lowLatency ? spinRecv(socket, buff + total_received, size - total_received, p)
+                                         : recv(socket, buff + total_received, size - total_received, 0);
         if (received <= 0) {
             std::string errorMsg = "Ошибка recv (" + context + "): " + std::string(strerror(errno));
             logError(p->logFile, errorMsg);
@@ -164,6 +194,7 @@ void safeRecv(int socket, void* buffer, size_t size, const Params* p, const std:
         }
         total_received += received;
     }
+    captureInbound(socket, CaptureKind::Data, buffer, size);
 }
 
 /**
@@ -185,164 +216,1859 @@ void safeSend(int socket, const void* data, size_t size, const Params* p, const
 }
 
 /**
- * @brief Основной метод установки соединения и обработки клиентов
- * @param p Указатель на параметры соединения
- * @return Код завершения (0 - успех, 1 - ошибка)
- * @throw std::system_error при ошибках сетевых операций
- * @details Выполняет полный цикл работы сервера: создание сокета, привязка, 
- * прослушивание, аутентификация клиента и обработка данных
+ * @brief Пул потоков параллельной свертки
+ * @param p Параметры соединения
+ * @return Общий для всех сессий пул, создаваемый при первом обращении
+ * @details Поток сессии сам обрабатывает одну из частей вектора, поэтому
+ * рабочих потоков на один меньше, чем Params::reduceThreads
  */
-int Connection::conn(const Params* p) {
-    // Инициализация генератора случайных чисел для соли
-    srand(static_cast<unsigned int>(time(nullptr)));
-    
-    int server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket == -1) {       
-        std::string errorMsg = "Ошибка создания сокета: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        throw std::system_error(errno, std::generic_category()); 
-    }
+static ThreadPool& reducePool(const Params* p) {
+    static ThreadPool pool(static_cast<size_t>(p->reduceThreads > 0
+        ? p->reduceThreads
+        : std::max(std::thread::hardware_concurrency(), 1u)) - 1);
+    return pool;
+}
 
-    // Устанавливаем опцию повторного использования адреса
-    int opt = 1;
-    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        std::string errorMsg = "Ошибка setsockopt: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-    }
+/**
+ * @brief Кэш результатов свертки
+ * @param p Параметры соединения
+ * @return Общий для всех сессий кэш или nullptr, если Params::cacheMemory равен 0
+ */
+static ResultCache* resultCache(const Params* p) {
+    static std::unique_ptr<ResultCache> cache(p->cacheMemory > 0
+        ? new ResultCache(static_cast<size_t>(p->cacheMemory) << 20)
+        : nullptr);
+    return cache.get();
+}
 
-    std::unique_ptr<sockaddr_in> self_addr(new sockaddr_in); 
-    self_addr->sin_family = AF_INET;
-    self_addr->sin_port = htons(p->Port);
-    self_addr->sin_addr.s_addr = inet_addr(p->Address.c_str());
+/**
+ * @brief Начальное значение хеша вектора
+ * @param kernel Ядро свертки
+ * @param encoding Кодировка элементов
+ * @param vector_size Размер вектора
+ * @return Значение, различающее одинаковые байты при разных вариантах свертки
+ * @details Значение открыто; секреты процесса к нему добавляет CacheKeyHasher
+ */
+static uint64_t cacheSeed(const ReduceKernel& kernel, PayloadEncoding encoding, uint32_t vector_size) {
+    return (static_cast<uint64_t>(vector_size) << 32)
+         | (static_cast<uint64_t>(encoding) << 24)
+         | (static_cast<uint64_t>(kernel.op) << 16)
+         | (static_cast<uint64_t>(kernel.type) << 8)
+         | static_cast<uint64_t>(kernel.policy);
+}
 
-    int rc = bind(server_socket, reinterpret_cast<const sockaddr*>(self_addr.get()), sizeof(sockaddr_in));
-    if (rc == -1) {
-        std::string errorMsg = "Ошибка bind: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        close(server_socket);
-        throw std::system_error(errno, std::generic_category());
+/**
+ * @brief Журналирование переполнения при свертке
+ * @param kernel Ядро свертки
+ * @param overflow Было ли переполнение
+ * @param p Параметры соединения
+ * @throw std::overflow_error при переполнении с политикой OverflowPolicy::Error
+ */
+static void reportOverflow(const ReduceKernel& kernel, bool overflow, const Params* p) {
+    // Перенос по модулю запрошен клиентом и ошибкой не является
+    if (overflow && kernel.policy != OverflowPolicy::Wrap) {
+        // Проверка на переполнение
+        logError(p->logFile, kernel.op == ReduceOp::Product ? "Обнаружено переполнение при умножении вектора"
+                                                            : "Обнаружено переполнение при суммировании вектора");
+        if (kernel.policy == OverflowPolicy::Error) {
+            throw std::overflow_error("переполнение при свертке вектора");
+        }
     }
+}
 
-    rc = listen(server_socket, 10); // Увеличили очередь подключений
-    if (rc == -1) {
-        std::string errorMsg = "Ошибка listen: " + std::string(strerror(errno));
-        logError(p->logFile, errorMsg);
-        close(server_socket);
-        throw std::system_error(errno, std::generic_category());
+/**
+ * @brief Свертка принятого вектора с учетом кэша результатов
+ * @param kernel Ядро свертки, согласованное при рукопожатии
+ * @param encoding Кодировка элементов, согласованная при рукопожатии
+ * @param payload Элементы вектора в сетевом представлении
+ * @param payload_size Размер принятых данных в байтах
+ * @param vector_size Размер вектора
+ * @param cache Кэш результатов или nullptr
+ * @param key Ключ вектора (используется только при включенном кэше)
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @return Результат свертки вектора
+ * @throw std::overflow_error при переполнении с политикой OverflowPolicy::Error
+ * @details Векторы от Params::parallelThreshold элементов сворачиваются по
+ * частям в пуле потоков, сжатые векторы декодируются блоками прямо в ядро.
+ * Общая часть потоковой и асинхронной сессий
+ */
+static ReduceResult reduceVector(const ReduceKernel& kernel, PayloadEncoding encoding,
+                                 const unsigned char* payload, size_t payload_size, uint32_t vector_size,
+                                 ResultCache* cache, const CacheKey& key, uint64_t trace_id, const Params* p) {
+    TraceSpan span("reduce", trace_id);
+    ReduceResult result;
+    std::memset(result.bytes, 0, sizeof(result.bytes));
+    result.size = kernel.resultSize;
+    CachedResult cached;
+    bool overflow;
+
+    if (cache != nullptr && cache->find(key, cached)) {
+        result = cached.result;
+        overflow = cached.overflow;
+    } else {
+        if (encoding != PayloadEncoding::Raw) {
+            if (!decodeReduce(kernel, encoding, payload, payload_size, vector_size, result, overflow)) {
+                logError(p->logFile, "Некорректная кодировка вектора размером: " + std::to_string(vector_size));
+                std::memset(result.bytes, 0, sizeof(result.bytes));
+                return result;
+            }
+        } else if (p->parallelThreshold != 0 && vector_size >= p->parallelThreshold) {
+            overflow = reduceParallel(kernel, payload, vector_size, reducePool(p), result);
+        } else {
+            overflow = reduceBlock(kernel, payload, vector_size, result);
+        }
+        if (cache != nullptr) {
+            cache->insert(key, CachedResult{result, overflow});
+        }
     }
 
-    // Логируем запуск сервера
-    std::string startMsg = "Сервер запущен на " + p->Address + ":" + std::to_string(p->Port);
-    logError(p->logFile, startMsg);
-
-    sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int client_socket = accept(server_socket, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
-    if (client_socket == -1) {
-        std::string errorMsg = "Ошибка accept: " + std::string(strerror(errno));
+    reportOverflow(kernel, overflow, p);
+    return result;
+}
+
+/**
+ * @brief Обработка одного вектора выбранным ядром свертки
+ * @param client_socket Сокет клиента
+ * @param vector_size Размер вектора
+ * @param kernel Ядро свертки, согласованное при рукопожатии
+ * @param encoding Кодировка элементов, согласованная при рукопожатии
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @return Результат свертки вектора
+ * @throw std::system_error при ошибках сетевых операций и слишком большом векторе (см. shm.h)
+ * @throw std::overflow_error при переполнении с политикой OverflowPolicy::Error
+ * @warning Проверяет переполнение и ограничивает размер вектора
+ * @details Вектор принимается целиком одним вызовом safeRecv и сворачивается
+ * специализированным ядром без поэлементных recv и ветвлений. Векторы от
+ * Params::parallelThreshold элементов сворачиваются по частям в пуле потоков.
+ * В сжатой кодировке перед элементами передается их размер в байтах.
+ * При включенном кэше повторно присланный вектор не сворачивается заново
+ */
+ReduceResult processVector(int client_socket, uint32_t vector_size, const ReduceKernel& kernel,
+                           PayloadEncoding encoding, uint64_t trace_id, const Params* p) {
+    ReduceResult result;
+    std::memset(result.bytes, 0, sizeof(result.bytes));
+    result.size = kernel.resultSize;
+
+    if (vector_size > p->maxVectorSize) { // Защита от слишком больших векторов
+        // Элементы не читаются, поэтому продолжать сессию нельзя (см. shm.h)
+        std::string errorMsg = "Слишком большой размер вектора: " + std::to_string(vector_size);
         logError(p->logFile, errorMsg);
-        close(server_socket);
-        throw std::system_error(errno, std::generic_category());
+        throw std::system_error(EMSGSIZE, std::generic_category());
     }
 
-    // Логируем подключение клиента
-    std::string connectMsg = "Клиент подключен: " + std::string(inet_ntoa(client_addr.sin_addr));
-    logError(p->logFile, connectMsg);
-
-    try {
-        // Получаем логин от клиента
-        char buffer[BUFFER_SIZE];
-        ssize_t received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
-        if (received_bytes == -1) {
-            std::string errorMsg = "Ошибка recv (логин): " + std::string(strerror(errno));
-            logError(p->logFile, errorMsg);
-            throw std::system_error(errno, std::generic_category());
+    ResultCache* cache = resultCache(p);
+    CacheKey key{};
+    // Буфер переиспользуется между векторами одного потока
+    thread_local std::vector<unsigned char> payload;
+    {
+        TraceSpan span("recv_vector", trace_id);
+        size_t payload_size = static_cast<size_t>(vector_size) * kernel.elemSize;
+        if (encoding != PayloadEncoding::Raw) {
+            uint32_t encoded_size;
+            safeRecv(client_socket, &encoded_size, sizeof(encoded_size), p, "размер закодированного вектора");
+            if (encoded_size > maxEncodedSize(kernel, encoding, vector_size)) {
+                // Присланные элементы не читаются, поэтому продолжать сессию нельзя
+                logError(p->logFile, "Слишком большой размер закодированного вектора: " + std::to_string(encoded_size));
+                throw std::system_error(EMSGSIZE, std::generic_category());
+            }
+            payload_size = encoded_size;
         }
+        payload.resize(payload_size);
 
-        if (received_bytes > 0) {
-            buffer[received_bytes] = '\0';
+        if (cache != nullptr) {
+            // Хеш считается по частям сразу после приема, пока данные в кэше процессора
+            CacheKeyHasher hasher(cacheSeed(kernel, encoding, vector_size));
+            for (size_t offset = 0; offset < payload.size(); ) {
+                size_t part = std::min<size_t>(payload.size() - offset, 64 * 1024);
+                safeRecv(client_socket, payload.data() + offset, part, p, "элементы вектора");
+                hasher.update(payload.data() + offset, part);
+                offset += part;
+            }
+            key = hasher.key();
+        } else {
+            safeRecv(client_socket, payload.data(), payload.size(), p, "элементы вектора");
         }
+    }
 
-        std::string client_login(buffer);
-        
-        // Ищем пользователя в файле
-        std::string user_password;
-        if (!findUserInFile(p->inFileName, client_login, user_password)) {
-            std::string errorMsg = "Пользователь не найден: " + client_login;
-            logError(p->logFile, errorMsg);
-            
-            std::string message = "ERR_USER_NOT_FOUND";
-            safeSend(client_socket, message.c_str(), message.length(), p, "ошибка пользователя");
-            
-            close(client_socket);
-            close(server_socket);
-            return 1;
+    return reduceVector(kernel, encoding, payload.data(), payload.size(), vector_size, cache, key, trace_id, p);
+}
+
+/**
+ * @brief Разбор приветственного сообщения клиента
+ * @param message Сообщение вида "логин[:ключ=значение,...]"
+ * @param options Параметры сессии (выходной параметр)
+ * @return Логин клиента
+ * @details Двоеточие не может входить в логин (оно разделяет логин и пароль
+ * в базе), поэтому старые клиенты, присылающие только логин, не затрагиваются
+ */
+std::string parseHello(const std::string& message, std::map<std::string, std::string>& options) {
+    size_t pos = message.find(':');
+    if (pos == std::string::npos) {
+        return message;
+    }
+
+    std::stringstream ss(message.substr(pos + 1));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            options[item] = "";
+        } else {
+            options[item.substr(0, eq)] = item.substr(eq + 1);
         }
+    }
+    return message.substr(0, pos);
+}
+
+/**
+ * @brief Значение параметра сессии
+ * @param options Параметры сессии
+ * @param key Имя параметра
+ * @param fallback Значение по умолчанию
+ * @return Значение параметра или fallback
+ */
+static std::string helloOption(const std::map<std::string, std::string>& options,
+                               const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
 
-        // Генерируем и отправляем случайную соль
-        std::string salt = generateSalt();
-        safeSend(client_socket, salt.c_str(), salt.length(), p, "соль");
+/**
+ * @brief Проверка количества векторов в пачке
+ * @param vectors_count Количество векторов, объявленное клиентом
+ * @param p Параметры соединения
+ * @throw std::system_error, если векторов больше MAX_BATCH_VECTORS
+ * @details Пачку нельзя обрезать: в постоянной сессии непрочитанные векторы
+ * были бы приняты за следующую пачку, поэтому сессия закрывается
+ */
+static void checkBatchSize(uint32_t vectors_count, const Params* p) {
+    if (vectors_count > MAX_BATCH_VECTORS) {
+        logError(p->logFile, "Слишком большое количество векторов: " + std::to_string(vectors_count));
+        throw std::system_error(EMSGSIZE, std::generic_category());
+    }
+}
 
-        // Получаем хеш от клиента
-        received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
-        if (received_bytes == -1) {
-            std::string errorMsg = "Ошибка recv (хеш): " + std::string(strerror(errno));
-            logError(p->logFile, errorMsg);
-            throw std::system_error(errno, std::generic_category());
+/**
+ * @brief Обработка пачки векторов
+ * @param client_socket Сокет клиента
+ * @param vectors_count Количество векторов в пачке
+ * @param kernel Ядро свертки сессии
+ * @param encoding Кодировка элементов сессии
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @throw std::system_error при ошибках сетевых операций и пачке больше MAX_BATCH_VECTORS
+ */
+static void processBatch(int client_socket, uint32_t vectors_count, const ReduceKernel& kernel,
+                         PayloadEncoding encoding, uint64_t trace_id, const Params* p) {
+    checkBatchSize(vectors_count, p);
+
+    // Обрабатываем каждый вектор
+    for (uint32_t vector_idx = 0; vector_idx < vectors_count; vector_idx++) {
+        uint32_t vector_size;
+        safeRecv(client_socket, &vector_size, sizeof(vector_size), p, "размер вектора");
+
+        ReduceResult result = processVector(client_socket, vector_size, kernel, encoding, trace_id, p);
+
+        TraceSpan span("send_result", trace_id);
+        captureResult(client_socket, result.size);
+        safeSend(client_socket, result.bytes, result.size, p, "результат вектора");
+    }
+}
+
+/**
+ * @brief Ожидание следующей пачки векторов в постоянной сессии
+ * @param client_socket Сокет клиента
+ * @param p Параметры соединения
+ * @return true если клиент прислал данные, false при простое или остановке сервера
+ * @details Канал пробуждения остается читаемым после запроса остановки,
+ * поэтому ожидающие сессии завершаются сразу, не дожидаясь таймаута
+ */
+static bool waitForBatch(int client_socket, const Params* p) {
+    if (stopRequested) {
+        logError(p->logFile, "Сессия закрыта: сервер останавливается");
+        return false;
+    }
+
+    pollfd fds[2] = {
+        {client_socket, POLLIN, 0},
+        {wakePipe[0], POLLIN, 0}
+    };
+    int timeout_ms = p->idleTimeout > 0 ? p->idleTimeout * 1000 : -1;
+    int ready = 0;
+    if (int spin = spinMicros(p)) {
+        // Следующая пачка часто приходит сразу: опрашиваем без блокировки
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin);
+        do {
+            ready = poll(fds, 2, 0);
+        } while (ready == 0 && std::chrono::steady_clock::now() < deadline);
+    }
+    if (ready <= 0) {
+        do {
+            ready = poll(fds, 2, timeout_ms);
+        } while (ready == -1 && errno == EINTR);
+    }
+
+    if (ready == 0) {
+        logError(p->logFile, "Сессия закрыта: истекло время простоя");
+        return false;
+    }
+    if (ready > 0 && !(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+        logError(p->logFile, "Сессия закрыта: сервер останавливается");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Ключ подписи билетов возобновления
+ * @param p Параметры соединения
+ * @return Ключ из файла Params::ticketKeyFile или случайный ключ процесса
+ * @throw std::system_error если файл ключа задан, но не читается или пуст
+ * @details Общий файл ключа позволяет принимать билеты после перезапуска
+ * и в других процессах сервера
+ */
+static const std::string& ticketKey(const Params* p) {
+    static const std::string key = [p]() {
+        if (p->ticketKeyFile.empty()) {
+            return generateKey(32);
         }
-        
-        if (received_bytes > 0) {
-            buffer[received_bytes] = '\0';
+        std::ifstream file(p->ticketKeyFile, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (contents.empty()) {
+            logError(p->logFile, "Не удалось прочитать ключ билетов: " + p->ticketKeyFile);
+            throw std::system_error(ENOENT, std::generic_category());
         }
+        return contents;
+    }();
+    return key;
+}
 
-        // Проверяем хеш
-        std::string computed_hash = auth(salt, user_password);
-        std::string response;
-        
-        if (std::string(buffer) == computed_hash) {
-            response = "OK";
-            logError(p->logFile, "Аутентификация успешна для пользователя: " + client_login);
+/**
+ * @brief Разрешены ли билеты возобновления на соединениях сервера
+ * @param p Параметры соединения
+ * @return true, если билеты включены и соединения недоступны для прослушивания
+ * @details Билет предъявительский, поэтому выдается и принимается только
+ * через TLS и Unix-сокеты (см. crypto.h)
+ */
+static bool ticketsAllowed(const Params* p) {
+    return p->ticketLifetime > 0 && (serverTls || p->addressFamily == AF_UNIX);
+}
+
+/**
+ * @brief Загрузка ключа билетов при запуске
+ * @param p Параметры соединения
+ * @throw std::system_error если файл ключа задан, но не читается или пуст
+ */
+static void startTickets(const Params* p) {
+    if (ticketsAllowed(p)) {
+        ticketKey(p);
+    } else if (p->ticketLifetime > 0) {
+        logError(p->logFile, "Билеты возобновления отключены: соединения TCP без TLS можно прослушать");
+    }
+}
+
+/**
+ * @struct Handshake
+ * @brief Состояние рукопожатия, общее для потоковой и асинхронной сессий
+ */
+struct Handshake {
+    std::map<std::string, std::string> options;   ///< Параметры сессии из приветствия
+    std::string login;                            ///< Логин клиента
+    std::string password;                         ///< Пароль пользователя из базы
+    const ReduceKernel* kernel = nullptr;         ///< Согласованное ядро свертки
+    PayloadEncoding encoding = PayloadEncoding::Raw; ///< Согласованная кодировка элементов
+    bool authenticated = false;                   ///< Пройдена ли аутентификация
+    uint64_t traceId = 0;                         ///< Идентификатор сессии для трассы
+};
+
+/**
+ * @brief Разбор приветствия: выбор ядра свертки, поиск пользователя и проверка билета
+ * @param hello Приветственное сообщение клиента
+ * @param hs Состояние рукопожатия (выходной параметр)
+ * @param p Параметры соединения
+ * @return Пустая строка или код ошибки для отправки клиенту
+ */
+static std::string beginHandshake(const char* hello, Handshake& hs, const Params* p) {
+    hs.login = parseHello(hello, hs.options);
+
+    // Выбираем ядро свертки; по умолчанию - насыщающее произведение uint16_t
+    hs.kernel = selectKernel(helloOption(hs.options, "op", "product"),
+                             helloOption(hs.options, "type", "uint16"),
+                             helloOption(hs.options, "ovf", "saturate"));
+    if (hs.kernel == nullptr) {
+        logError(p->logFile, "Неподдерживаемый вариант свертки для пользователя: " + hs.login);
+        return "ERR_UNSUPPORTED";
+    }
+    if (!selectEncoding(helloOption(hs.options, "enc", "raw"), *hs.kernel, hs.encoding)) {
+        logError(p->logFile, "Неподдерживаемая кодировка векторов для пользователя: " + hs.login);
+        return "ERR_UNSUPPORTED";
+    }
+
+    // Ищем пользователя в файле
+    bool found;
+    {
+        TraceSpan span("findUserInFile", hs.traceId);
+        found = findUserInFile(p->inFileName, hs.login, hs.password);
+    }
+    if (!found) {
+        std::string errorMsg = "Пользователь не найден: " + hs.login;
+        logError(p->logFile, errorMsg);
+        return "ERR_USER_NOT_FOUND";
+    }
+
+    // Клиент с действующим билетом пропускает обмен солью и хешем
+    std::string ticket = helloOption(hs.options, "ticket", "");
+    if (!ticket.empty()) {
+        if (ticketsAllowed(p) && verifyTicket(ticketKey(p), hs.login, ticket, time(nullptr))) {
+            hs.authenticated = true;
+            logError(p->logFile, "Сессия возобновлена по билету для пользователя: " + hs.login);
         } else {
-            response = "ERR_AUTH_FAILED";
-            logError(p->logFile, "Ошибка аутентификации: неверный хеш для пользователя: " + client_login);
+            logError(p->logFile, "Недействительный билет, полная аутентификация для пользователя: " + hs.login);
         }
-        
-        safeSend(client_socket, response.c_str(), response.length(), p, "результат аутентификации");
+    }
+    return "";
+}
 
-        if (response != "OK") {
-            close(client_socket);
-            close(server_socket);
-            return 1;
+/**
+ * @brief Проверка хеша клиента и формирование ответа на аутентификацию
+ * @param hs Состояние рукопожатия
+ * @param salt Отправленная клиенту соль (не используется после входа по билету)
+ * @param hash Хеш, присланный клиентом
+ * @param p Параметры соединения
+ * @return Ответ клиенту: "OK", "OK:билет" или "ERR_AUTH_FAILED"
+ */
+static std::string finishHandshake(Handshake& hs, const std::string& salt, const char* hash, const Params* p) {
+    std::string response = "OK";
+    if (!hs.authenticated) {
+        // Проверяем хеш
+        std::string computed_hash;
+        {
+            TraceSpan span("auth", hs.traceId);
+            computed_hash = auth(salt, hs.password);
         }
 
-        // Получаем количество векторов
-        uint32_t vectors_count;
-        safeRecv(client_socket, &vectors_count, sizeof(vectors_count), p, "количество векторов");
-        
-        // Проверяем разумность количества векторов
-        if (vectors_count > 1000) {
-            logError(p->logFile, "Слишком большое количество векторов: " + std::to_string(vectors_count));
-            vectors_count = 1000; // Ограничиваем
+        if (std::string(hash) == computed_hash) {
+            hs.authenticated = true;
+            logError(p->logFile, "Аутентификация успешна для пользователя: " + hs.login);
+        } else {
+            response = "ERR_AUTH_FAILED";
+            logError(p->logFile, "Ошибка аутентификации: неверный хеш для пользователя: " + hs.login);
         }
+    }
 
-        // Обрабатываем каждый вектор
-        for (uint32_t vector_idx = 0; vector_idx < vectors_count; vector_idx++) {
-            uint32_t vector_size;
-            safeRecv(client_socket, &vector_size, sizeof(vector_size), p, "размер вектора");
+    // По запросу клиента выдаем билет для быстрого переподключения
+    if (hs.authenticated && hs.options.count("resume") && ticketsAllowed(p)) {
+        response += ":" + issueTicket(ticketKey(p), hs.login, time(nullptr) + p->ticketLifetime);
+    }
+    return response;
+}
+
+/**
+ * @brief Загрузка сертификата TLS при запуске
+ * @param p Параметры соединения
+ * @throw std::system_error, если ядро не поддерживает kTLS или сертификат не загрузился
+ * @details Повторный вызов в рабочем процессе использует контекст,
+ * унаследованный от супервизора
+ */
+static void startTls(const Params* p) {
+    if (p->tlsCert.empty() || serverTls) {
+        return;
+    }
+    // Без kTLS соединения пришлось бы шифровать в библиотеке, поэтому
+    // сервер не запускается вовсе
+    if (!tlsKernelSupported()) {
+        logError(p->logFile, "Ядро не поддерживает kTLS (модуль tls не загружен)");
+        throw std::system_error(ENOPROTOOPT, std::generic_category());
+    }
+    std::unique_ptr<TlsContext> context(new TlsContext());
+    std::string error;
+    if (!context->init(p->tlsCert, p->tlsKey, error)) {
+        logError(p->logFile, "Ошибка загрузки сертификата TLS: " + error);
+        throw std::system_error(EINVAL, std::generic_category());
+    }
+    serverTls = std::move(context);
+    logError(p->logFile, "TLS включен, записи шифруются ядром (kTLS)");
+}
+
+/**
+ * @brief TLS-рукопожатие с клиентом
+ * @param client_socket Сокет клиента
+ * @param trace_id Идентификатор сессии для трассировки
+ * @param p Параметры соединения
+ * @return false, если рукопожатие не удалось или не завершилось за
+ * TLS_HANDSHAKE_TIMEOUT_MS
+ */
+static bool acceptTls(int client_socket, uint64_t trace_id, const Params* p) {
+    TraceSpan span("tls_handshake", trace_id);
+    TlsHandshake handshake(*serverTls, client_socket);
+    if (handshake.run(TLS_HANDSHAKE_TIMEOUT_MS) == TlsStep::Failed) {
+        logError(p->logFile, "Ошибка TLS-рукопожатия: " + handshake.error());
+        return false;
+    }
+    return true;
+}
 
-            uint32_t result = processVector(client_socket, vector_size, p);
-            
-            safeSend(client_socket, &result, sizeof(result), p, "результат вектора");
+/**
+ * @brief TLS-рукопожатие с клиентом в сопрограмме
+ * @param reactor Реактор
+ * @param client_socket Неблокирующий сокет клиента
+ * @param trace_id Идентификатор сессии для трассировки
+ * @param p Параметры соединения
+ * @return false, если рукопожатие не удалось или не завершилось за
+ * TLS_HANDSHAKE_TIMEOUT_MS
+ */
+static Task<bool> asyncAcceptTls(Reactor& reactor, int client_socket, uint64_t trace_id, const Params* p) {
+    TraceSpan span("tls_handshake", trace_id);
+    TlsHandshake handshake(*serverTls, client_socket);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TLS_HANDSHAKE_TIMEOUT_MS);
+    TlsStep step;
+    while ((step = handshake.step()) == TlsStep::WantRead || step == TlsStep::WantWrite) {
+        // Ограничение действует на рукопожатие целиком, а не на каждое ожидание
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        Reactor::WaitResult result = left <= 0 ? Reactor::WaitResult::Timeout
+            : step == TlsStep::WantRead ? co_await reactor.readable(client_socket, static_cast<int>(left))
+                                        : co_await reactor.writable(client_socket);
+        if (result != Reactor::WaitResult::Ready) {
+            logError(p->logFile, "Истекло время TLS-рукопожатия");
+            co_return false;
         }
+    }
+    if (step == TlsStep::Failed) {
+        logError(p->logFile, "Ошибка TLS-рукопожатия: " + handshake.error());
+        co_return false;
+    }
+    co_return true;
+}
 
-        logError(p->logFile, "Обработка завершена успешно");
+/**
+ * @brief Асинхронное получение данных фиксированного размера
+ * @param reactor Реактор сессии
+ * @param socket Сокет
+ * @param buffer Буфер для данных
+ * @param size Размер данных
+ * @param p Параметры соединения
+ * @param context Контекст для сообщения об ошибке
+ * @throw std::system_error при ошибках получения данных
+ */
+static Task<void> asyncRecvAll(Reactor& reactor, int socket, void* buffer, size_t size, const Params* p, std::string context) {
+    size_t total_received = 0;
+    char* buff = reinterpret_cast<char*>(buffer);
 
-    } catch (const std::exception& e) {
-        std::string errorMsg = "Исключение в обработке клиента: " + std::string(e.what());
-        logError(p->logFile, errorMsg);
+    while (total_received < size) {
+        ssize_t received = co_await asyncRecv(reactor, socket, buff + total_received, size - total_received);
+        if (received <= 0) {
+            std::string errorMsg = "Ошибка recv (" + context + "): " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            throw std::system_error(errno, std::generic_category());
+        }
+        total_received += received;
     }
+    captureInbound(socket, CaptureKind::Data, buffer, size);
+}
 
-    close(client_socket);
-    close(server_socket);
-    return 0;
+/**
+ * @brief Асинхронная отправка данных
+ * @param reactor Реактор сессии
+ * @param socket Сокет
+ * @param data Данные для отправки
+ * @param size Размер данных
+ * @param p Параметры соединения
+ * @param context Контекст для сообщения об ошибке
+ * @throw std::system_error при ошибках отправки данных
+ */
+static Task<void> asyncSendAll(Reactor& reactor, int socket, const void* data, size_t size, const Params* p, std::string context) {
+    ssize_t sent_bytes = co_await asyncSend(reactor, socket, data, size);
+    if (sent_bytes == -1) {
+        std::string errorMsg = "Ошибка send (" + context + "): " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+}
+
+/**
+ * @brief Асинхронная обработка одного вектора
+ * @param reactor Реактор сессии
+ * @param client_socket Сокет клиента
+ * @param vector_size Размер вектора
+ * @param kernel Ядро свертки сессии
+ * @param encoding Кодировка элементов сессии
+ * @param payload Буфер пачки для элементов вектора
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @return Результат свертки вектора
+ * @throw std::system_error при ошибках сетевых операций и слишком большом векторе (см. shm.h)
+ * @throw std::overflow_error при переполнении с политикой OverflowPolicy::Error
+ * @details Асинхронный вариант processVector(). Сессии одного потока
+ * чередуются, поэтому буфер принадлежит пачке, а не потоку
+ */
+static Task<ReduceResult> asyncProcessVector(Reactor& reactor, int client_socket, uint32_t vector_size,
+                                             const ReduceKernel& kernel, PayloadEncoding encoding,
+                                             std::vector<unsigned char>& payload, uint64_t trace_id, const Params* p) {
+    ReduceResult result;
+    std::memset(result.bytes, 0, sizeof(result.bytes));
+    result.size = kernel.resultSize;
+
+    if (vector_size > p->maxVectorSize) { // Защита от слишком больших векторов
+        // Элементы не читаются, поэтому продолжать сессию нельзя (см. shm.h)
+        std::string errorMsg = "Слишком большой размер вектора: " + std::to_string(vector_size);
+        logError(p->logFile, errorMsg);
+        throw std::system_error(EMSGSIZE, std::generic_category());
+    }
+
+    ResultCache* cache = resultCache(p);
+    CacheKey key{};
+
+    {
+        TraceSpan span("recv_vector", trace_id);
+        size_t payload_size = static_cast<size_t>(vector_size) * kernel.elemSize;
+        if (encoding != PayloadEncoding::Raw) {
+            uint32_t encoded_size;
+            co_await asyncRecvAll(reactor, client_socket, &encoded_size, sizeof(encoded_size), p, "размер закодированного вектора");
+            if (encoded_size > maxEncodedSize(kernel, encoding, vector_size)) {
+                // Присланные элементы не читаются, поэтому продолжать сессию нельзя
+                logError(p->logFile, "Слишком большой размер закодированного вектора: " + std::to_string(encoded_size));
+                throw std::system_error(EMSGSIZE, std::generic_category());
+            }
+            payload_size = encoded_size;
+        }
+        payload.resize(payload_size);
+
+        if (cache != nullptr) {
+            CacheKeyHasher hasher(cacheSeed(kernel, encoding, vector_size));
+            for (size_t offset = 0; offset < payload.size(); ) {
+                size_t part = std::min<size_t>(payload.size() - offset, 64 * 1024);
+                co_await asyncRecvAll(reactor, client_socket, payload.data() + offset, part, p, "элементы вектора");
+                hasher.update(payload.data() + offset, part);
+                offset += part;
+            }
+            key = hasher.key();
+        } else {
+            co_await asyncRecvAll(reactor, client_socket, payload.data(), payload.size(), p, "элементы вектора");
+        }
+    }
+
+    co_return reduceVector(kernel, encoding, payload.data(), payload.size(), vector_size, cache, key, trace_id, p);
+}
+
+/**
+ * @brief Асинхронная обработка пачки векторов
+ * @param reactor Реактор сессии
+ * @param client_socket Сокет клиента
+ * @param vectors_count Количество векторов в пачке
+ * @param kernel Ядро свертки сессии
+ * @param encoding Кодировка элементов сессии
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @throw std::system_error при ошибках сетевых операций и пачке больше MAX_BATCH_VECTORS
+ * @details Буфер элементов освобождается после пачки, поэтому простаивающая
+ * постоянная сессия занимает только кадры своих сопрограмм
+ */
+static Task<void> asyncProcessBatch(Reactor& reactor, int client_socket, uint32_t vectors_count,
+                                    const ReduceKernel& kernel, PayloadEncoding encoding,
+                                    uint64_t trace_id, const Params* p) {
+    checkBatchSize(vectors_count, p);
+
+    std::vector<unsigned char> payload;
+    for (uint32_t vector_idx = 0; vector_idx < vectors_count; vector_idx++) {
+        uint32_t vector_size;
+        co_await asyncRecvAll(reactor, client_socket, &vector_size, sizeof(vector_size), p, "размер вектора");
+
+        ReduceResult result = co_await asyncProcessVector(reactor, client_socket, vector_size, kernel, encoding, payload, trace_id, p);
+
+        TraceSpan span("send_result", trace_id);
+        captureResult(client_socket, result.size);
+        co_await asyncSendAll(reactor, client_socket, result.bytes, result.size, p, "результат вектора");
+    }
+}
+
+/**
+ * @brief Асинхронное ожидание следующей пачки векторов в постоянной сессии
+ * @param reactor Реактор сессии
+ * @param client_socket Сокет клиента
+ * @param p Параметры соединения
+ * @return true если клиент прислал данные, false при простое или остановке сервера
+ * @details При остановке сервера ожидание прерывается через Reactor::cancelIdle()
+ */
+static Task<bool> asyncWaitForBatch(Reactor& reactor, int client_socket, const Params* p) {
+    if (stopRequested) {
+        logError(p->logFile, "Сессия закрыта: сервер останавливается");
+        co_return false;
+    }
+
+    int timeout_ms = p->idleTimeout > 0 ? p->idleTimeout * 1000 : -1;
+    Reactor::WaitResult result = co_await reactor.readable(client_socket, timeout_ms, true);
+    if (result == Reactor::WaitResult::Timeout) {
+        logError(p->logFile, "Сессия закрыта: истекло время простоя");
+        co_return false;
+    }
+    if (result == Reactor::WaitResult::Cancelled) {
+        logError(p->logFile, "Сессия закрыта: сервер останавливается");
+        co_return false;
+    }
+    co_return true;
+}
+
+/**
+ * @brief Создание канала разделяемой памяти для клиента
+ * @param client_socket Сокет клиента
+ * @param encoding Кодировка элементов сессии
+ * @param p Параметры соединения
+ * @return Канал или nullptr, если транспорт недоступен
+ * @details Дескрипторы передаются только через Unix-сокет, поэтому клиентам
+ * TCP отказывается. В режиме сопрограмм ожидание на eventfd заняло бы поток
+ * реактора, поэтому транспорт доступен только в режиме потоков. Кольца
+ * передают элементы только без сжатия. При отказе сессия продолжается через сокет
+ */
+static std::unique_ptr<ShmChannel> openShm(int client_socket, PayloadEncoding encoding, const Params* p) {
+    if (encoding != PayloadEncoding::Raw) {
+        logError(p->logFile, "Разделяемая память не поддерживает сжатые кодировки векторов");
+        return nullptr;
+    }
+
+    sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(client_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0
+        || addr.ss_family != AF_UNIX || p->sessionMode != "threads") {
+        logError(p->logFile, "Разделяемая память доступна только через Unix-сокет в режиме потоков");
+        return nullptr;
+    }
+
+    try {
+        return std::unique_ptr<ShmChannel>(new ShmChannel());
+    } catch (const std::system_error& e) {
+        logError(p->logFile, "Ошибка создания разделяемой памяти: " + std::string(e.what()));
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Проверка результата ожидания внутри пачки
+ * @param result Результат ожидания
+ * @param p Параметры соединения
+ * @param context Контекст для сообщения об ошибке
+ * @throw std::system_error если клиент отключился
+ */
+static void shmCheck(ShmChannel::Wait result, const Params* p, const std::string& context) {
+    if (result != ShmChannel::Wait::Ready) {
+        logError(p->logFile, "Ошибка shm (" + context + "): клиент отключился");
+        throw std::system_error(ECONNRESET, std::generic_category());
+    }
+}
+
+/**
+ * @brief Проверка длины непрерывного участка кольца
+ * @param contiguous Длина участка, которую вернул ShmRing::front или ShmRing::back
+ * @param need Сколько байт нужно для очередной записи
+ * @param p Параметры соединения
+ * @param context Контекст для сообщения об ошибке
+ * @throw std::system_error (EPROTO), если участок короче записи
+ * @details После успешного ожидания участок короче записи бывает, только
+ * если клиент изменил счетчик кольца в обратную сторону
+ */
+static void shmCheckRecord(size_t contiguous, size_t need, const Params* p, const std::string& context) {
+    if (contiguous < need) {
+        logError(p->logFile, "Ошибка shm (" + context + "): клиент нарушил счетчики кольца");
+        throw std::system_error(EPROTO, std::generic_category());
+    }
+}
+
+/**
+ * @brief Получение 8-байтной записи с числом из кольца запросов
+ * @param channel Канал разделяемой памяти
+ * @param client_socket Сокет клиента
+ * @param p Параметры соединения
+ * @param context Контекст для сообщения об ошибке
+ * @return Значение uint32_t из начала записи
+ * @throw std::system_error если клиент отключился или нарушил счетчики кольца
+ */
+static uint32_t shmRecvWord(ShmChannel& channel, int client_socket, const Params* p, const std::string& context) {
+    shmCheck(channel.waitRequests(SHM_RECORD_ALIGN, client_socket, -1, -1), p, context);
+    size_t contiguous;
+    const unsigned char* record = channel.requests.front(contiguous);
+    shmCheckRecord(contiguous, SHM_RECORD_ALIGN, p, context);
+    uint32_t value;
+    std::memcpy(&value, record, sizeof(value));
+    channel.consumeRequests(SHM_RECORD_ALIGN);
+    captureInbound(client_socket, CaptureKind::Data, &value, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Свертка вектора прямо в кольце запросов
+ * @param channel Канал разделяемой памяти
+ * @param client_socket Сокет клиента
+ * @param vector_size Размер вектора
+ * @param kernel Ядро свертки сессии
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @return Результат свертки вектора
+ * @throw std::system_error если клиент отключился, нарушил счетчики кольца
+ * или вектор больше Params::maxVectorSize
+ * @throw std::overflow_error при переполнении с политикой OverflowPolicy::Error
+ * @details Элементы не копируются: ядро получает непрерывные участки кольца
+ * по мере их публикации клиентом. Кэш и параллельная свертка здесь не
+ * применяются, так как вектор никогда не собирается целиком
+ */
+static ReduceResult shmProcessVector(ShmChannel& channel, int client_socket, uint32_t vector_size,
+                                     const ReduceKernel& kernel, uint64_t trace_id, const Params* p) {
+    ReduceResult result;
+    std::memset(result.bytes, 0, sizeof(result.bytes));
+    result.size = kernel.resultSize;
+
+    if (vector_size > p->maxVectorSize) { // Защита от слишком больших векторов; элементы не читаются
+        std::string errorMsg = "Слишком большой размер вектора: " + std::to_string(vector_size);
+        logError(p->logFile, errorMsg);
+        throw std::system_error(EMSGSIZE, std::generic_category());
+    }
+
+    size_t bytes = static_cast<size_t>(vector_size) * kernel.elemSize;
+    size_t left = (bytes + SHM_RECORD_ALIGN - 1) / SHM_RECORD_ALIGN * SHM_RECORD_ALIGN;
+    size_t elems_left = vector_size;
+
+    TraceSpan span("reduce", trace_id);
+    ReduceState state;
+    kernel.init(state);
+    while (left > 0) {
+        shmCheck(channel.waitRequests(SHM_RECORD_ALIGN, client_socket, -1, -1), p, "элементы вектора");
+        size_t contiguous;
+        const unsigned char* data = channel.requests.front(contiguous);
+        shmCheckRecord(contiguous, elems_left > 0 ? kernel.elemSize : 1, p, "элементы вектора");
+        size_t take = std::min(contiguous, left);
+
+        size_t count = std::min(take / kernel.elemSize, elems_left);
+        if (count > 0) {
+            kernel.feed(state, data, count);
+            captureInbound(client_socket, CaptureKind::Data, data, count * kernel.elemSize);
+        }
+        elems_left -= count;
+        // После последнего элемента остаток участка - заполнение до 8 байт
+        size_t used = elems_left == 0 ? take : count * kernel.elemSize;
+        channel.consumeRequests(used);
+        left -= used;
+    }
+
+    reportOverflow(kernel, kernel.finish(state, result.bytes), p);
+    return result;
+}
+
+/**
+ * @brief Запись результата в кольцо ответов
+ * @param channel Канал разделяемой памяти
+ * @param client_socket Сокет клиента
+ * @param result Результат свертки
+ * @param p Параметры соединения
+ * @throw std::system_error если клиент отключился или нарушил счетчики кольца
+ */
+static void shmSendResult(ShmChannel& channel, int client_socket, const ReduceResult& result, const Params* p) {
+    shmCheck(channel.waitResponseSpace(SHM_RECORD_ALIGN, client_socket), p, "результат вектора");
+    size_t contiguous;
+    unsigned char* slot = channel.responses.back(contiguous);
+    shmCheckRecord(contiguous, SHM_RECORD_ALIGN, p, "результат вектора");
+    std::memset(slot, 0, SHM_RECORD_ALIGN);
+    std::memcpy(slot, result.bytes, result.size);
+    channel.publishResponses(SHM_RECORD_ALIGN);
+    captureResult(client_socket, result.size);
+}
+
+/**
+ * @brief Обмен пачками векторов через разделяемую память
+ * @param channel Канал разделяемой памяти
+ * @param client_socket Сокет клиента
+ * @param kernel Ядро свертки сессии
+ * @param trace_id Идентификатор сессии для трассы
+ * @param p Параметры соединения
+ * @throw std::system_error если клиент отключился посреди пачки или прислал
+ * пачку больше MAX_BATCH_VECTORS
+ * @details Сессия всегда постоянная: пачки идут до END_OF_SESSION, простоя
+ * дольше Params::idleTimeout, закрытия сокета клиентом или остановки сервера
+ */
+static void shmSession(ShmChannel& channel, int client_socket, const ReduceKernel& kernel, uint64_t trace_id, const Params* p) {
+    int timeout_ms = p->idleTimeout > 0 ? p->idleTimeout * 1000 : -1;
+    for (;;) {
+        ShmChannel::Wait waited = ShmChannel::Wait::Stopped;
+        if (!stopRequested) {
+            TraceSpan span("wait_batch", trace_id);
+            waited = channel.waitRequests(SHM_RECORD_ALIGN, client_socket, wakePipe[0], timeout_ms);
+        }
+        if (waited == ShmChannel::Wait::Timeout) {
+            logError(p->logFile, "Сессия закрыта: истекло время простоя");
+            return;
+        }
+        if (waited == ShmChannel::Wait::Stopped) {
+            logError(p->logFile, "Сессия закрыта: сервер останавливается");
+            return;
+        }
+        if (waited == ShmChannel::Wait::Closed) {
+            logError(p->logFile, "Сессия закрыта: клиент отключился");
+            return;
+        }
+
+        uint32_t vectors_count = shmRecvWord(channel, client_socket, p, "количество векторов");
+        if (vectors_count == END_OF_SESSION) {
+            return;
+        }
+        checkBatchSize(vectors_count, p);
+
+        for (uint32_t vector_idx = 0; vector_idx < vectors_count; vector_idx++) {
+            uint32_t vector_size = shmRecvWord(channel, client_socket, p, "размер вектора");
+            ReduceResult result = shmProcessVector(channel, client_socket, vector_size, kernel, trace_id, p);
+
+            TraceSpan span("send_result", trace_id);
+            shmSendResult(channel, client_socket, result, p);
+        }
+    }
+}
+
+/**
+ * @brief Обработчик сигналов остановки (SIGTERM, SIGINT)
+ * @param signum Номер сигнала
+ */
+static void onStopSignal(int signum) {
+    (void)signum;
+    Connection::requestStop();
+}
+
+/**
+ * @brief Запрос плавной остановки сервера
+ * @details Безопасна для вызова из обработчика сигнала
+ */
+void Connection::requestStop() {
+    stopRequested = true;
+    if (wakePipe[1] != -1) {
+        char c = 1;
+        ssize_t rc = write(wakePipe[1], &c, 1);
+        (void)rc;
+    }
+}
+
+/**
+ * @brief Заполнение адреса слушающего сокета по параметрам
+ * @param p Параметры соединения
+ * @param addr Адрес (выходной параметр)
+ * @return Длина адреса или 0, если адрес некорректен
+ * @details Для Unix-сокетов "unix:путь" задает файл сокета, а "@имя" или
+ * "unix:@имя" - имя в абстрактном пространстве Linux (без файла)
+ */
+static socklen_t listenerAddress(const Params* p, sockaddr_storage& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+
+    if (p->addressFamily == AF_UNIX) {
+        sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&addr);
+        un->sun_family = AF_UNIX;
+        std::string path = unixSocketPath(p->Address);
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+            return 0;
+        }
+        std::memcpy(un->sun_path, path.data(), path.size());
+        if (path[0] == '@') {
+            // Абстрактное имя начинается с нулевого байта и не завершается нулем
+            un->sun_path[0] = '\0';
+            return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        return sizeof(sockaddr_un);
+    }
+
+    if (p->addressFamily == AF_INET6) {
+        sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(&addr);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(p->Port);
+        std::string host = p->Address;
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        }
+        return inet_pton(AF_INET6, host.c_str(), &in6->sin6_addr) == 1 ? sizeof(sockaddr_in6) : 0;
+    }
+
+    sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&addr);
+    in->sin_family = AF_INET;
+    in->sin_port = htons(p->Port);
+    return inet_pton(AF_INET, p->Address.c_str(), &in->sin_addr) == 1 ? sizeof(sockaddr_in) : 0;
+}
+
+/**
+ * @brief Описание адреса клиента для журнала
+ * @param addr Адрес клиента, полученный от accept
+ * @param client_socket Сокет клиента
+ * @return Строка с адресом
+ * @details Для Unix-сокетов адреса нет, поэтому в журнал пишутся pid и uid
+ * процесса клиента
+ */
+static std::string peerName(const sockaddr_storage& addr, int client_socket) {
+    char host[INET6_ADDRSTRLEN] = "";
+    if (addr.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(&addr)->sin_addr, host, sizeof(host));
+        return host;
+    }
+    if (addr.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(&addr)->sin6_addr, host, sizeof(host));
+        return host;
+    }
+
+    ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(client_socket, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+        return "unix (pid " + std::to_string(cred.pid) + ", uid " + std::to_string(cred.uid) + ")";
+    }
+    return "unix";
+}
+
+/**
+ * @brief Создание, привязка и прослушивание серверного сокета
+ * @param p Параметры соединения
+ * @return Слушающий сокет
+ * @throw std::system_error при ошибках сетевых операций и если путь
+ * Unix-сокета занят работающим сервером
+ * @details Семейство сокета (AF_INET, AF_INET6 или AF_UNIX) определяется
+ * синтаксисом параметра --address
+ */
+static int createListener(const Params* p) {
+    sockaddr_storage self_addr;
+    socklen_t self_len = listenerAddress(p, self_addr);
+    if (self_len == 0) {
+        logError(p->logFile, "Некорректный адрес сервера: " + p->Address);
+        throw std::system_error(EINVAL, std::generic_category());
+    }
+
+    int server_socket = socket(p->addressFamily, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server_socket == -1) {       
+        std::string errorMsg = "Ошибка создания сокета: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category()); 
+    }
+
+    if (p->addressFamily == AF_UNIX) {
+        // Удаляем файл сокета, оставшийся от предыдущего запуска, но не
+        // отбираем путь у работающего сервера
+        const sockaddr_un* un = reinterpret_cast<const sockaddr_un*>(&self_addr);
+        if (un->sun_path[0] != '\0' && !removeStaleSocket(un->sun_path)) {
+            logError(p->logFile, "Адрес уже используется работающим сервером: " + p->Address);
+            close(server_socket);
+            throw std::system_error(EADDRINUSE, std::generic_category());
+        }
+    } else {
+        // Устанавливаем опцию повторного использования адреса
+        int opt = 1;
+        if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+            std::string errorMsg = "Ошибка setsockopt: " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+        }
+    }
+
+    int rc = bind(server_socket, reinterpret_cast<const sockaddr*>(&self_addr), self_len);
+    if (rc == -1) {
+        std::string errorMsg = "Ошибка bind: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(server_socket);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    rc = listen(server_socket, 10); // Увеличили очередь подключений
+    if (rc == -1) {
+        std::string errorMsg = "Ошибка listen: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(server_socket);
+        throw std::system_error(errno, std::generic_category());
+    }
+    return server_socket;
+}
+
+/**
+ * @brief Запуск сессии клиента в отдельном потоке
+ * @param client_socket Сокет клиента
+ * @param p Параметры соединения
+ * @details Сокет регистрируется в множестве активных сессий, чтобы при
+ * истечении времени остановки его можно было принудительно закрыть
+ */
+static void startSession(int client_socket, const Params* p) {
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        activeSessions.insert(client_socket);
+    }
+    std::thread([client_socket, p]() {
+        Connection::session(client_socket, p);
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            activeSessions.erase(client_socket);
+        }
+        close(client_socket);
+        sessionsDone.notify_all();
+    }).detach();
+}
+
+/**
+ * @brief Сессия клиента в сопрограмме с освобождением сокета по завершении
+ * @param reactor Реактор
+ * @param client_socket Сокет клиента, уже зарегистрированный в активных сессиях
+ * @param p Параметры соединения
+ */
+static Task<void> runAsyncSession(Reactor& reactor, int client_socket, const Params* p) {
+    co_await Connection::asyncSession(reactor, client_socket, p);
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        activeSessions.erase(client_socket);
+    }
+    close(client_socket);
+    sessionsDone.notify_all();
+}
+
+/**
+ * @brief Прием клиентов в потоке реактора
+ * @param reactor Реактор
+ * @param server_socket Слушающий сокет
+ * @param p Параметры соединения
+ * @details Завершается, когда ожидание на слушающем сокете отменяется
+ * при остановке сервера или передаче сокета новому процессу
+ */
+static Task<void> acceptLoop(Reactor& reactor, int server_socket, const Params* p) {
+    while (!stopRequested) {
+        sockaddr_storage client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_socket = co_await asyncAccept(reactor, server_socket, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+        if (client_socket == -1) {
+            if (errno == ECANCELED) {
+                break;
+            }
+            if (errno != ECONNABORTED) {
+                std::string errorMsg = "Ошибка accept: " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+            }
+            continue;
+        }
+
+        // Логируем подключение клиента
+        std::string connectMsg = "Клиент подключен: " + peerName(client_addr, client_socket);
+        logError(p->logFile, connectMsg);
+        tuneSocket(client_socket, p);
+
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            activeSessions.insert(client_socket);
+        }
+        reactor.spawn(runAsyncSession(reactor, client_socket, p));
+    }
+}
+
+/**
+ * @brief Ожидание завершения активных сессий
+ * @param p Параметры соединения
+ * @details Сессии, не уложившиеся в Params::drainTimeout, закрываются
+ * принудительно через shutdown(), что прерывает их блокирующие recv/send
+ */
+static void drainSessions(const Params* p) {
+    std::unique_lock<std::mutex> lock(sessionsMutex);
+    if (!activeSessions.empty()) {
+        logError(p->logFile, "Ожидание завершения активных сессий: " + std::to_string(activeSessions.size()));
+    }
+    bool drained = sessionsDone.wait_for(lock, std::chrono::seconds(std::max(p->drainTimeout, 0)),
+        []() { return activeSessions.empty(); });
+    if (!drained) {
+        logError(p->logFile, "Истекло время ожидания, принудительное закрытие сессий: " + std::to_string(activeSessions.size()));
+        for (int client_socket : activeSessions) {
+            shutdown(client_socket, SHUT_RDWR);
+        }
+        sessionsDone.wait(lock, []() { return activeSessions.empty(); });
+    }
+}
+
+/**
+ * @brief Описание адреса сервера для журнала
+ * @param p Параметры соединения
+ * @return Адрес с портом или путь Unix-сокета
+ */
+static std::string listenerName(const Params* p) {
+    if (p->addressFamily == AF_INET6 && p->Address.front() != '[') {
+        return "[" + p->Address + "]:" + std::to_string(p->Port);
+    }
+    if (p->addressFamily != AF_UNIX) {
+        return p->Address + ":" + std::to_string(p->Port);
+    }
+    return p->Address;
+}
+
+/**
+ * @struct WorkerSlot
+ * @brief Место рабочего процесса в супервизоре
+ */
+struct WorkerSlot {
+    pid_t pid = -1;                                     ///< Процесс (-1 - не запущен)
+    std::chrono::steady_clock::time_point started;      ///< Время запуска
+    std::chrono::steady_clock::time_point restartAt;    ///< Время следующего запуска
+    long delay = 0;                                     ///< Текущая задержка перезапуска (мс)
+};
+
+/**
+ * @brief Обработчик SIGCHLD в супервизоре
+ * @param signum Номер сигнала
+ * @details Только пробуждает цикл супервизора; процессы собирает сам цикл
+ */
+static void onChildSignal(int signum) {
+    (void)signum;
+    int saved_errno = errno;
+    if (wakePipe[1] != -1) {
+        char c = 0;
+        ssize_t rc = write(wakePipe[1], &c, 1);
+        (void)rc;
+    }
+    errno = saved_errno;
+}
+
+/**
+ * @brief Запуск рабочего процесса
+ * @param index Номер рабочего процесса
+ * @param server_socket Слушающий сокет супервизора
+ * @param nodes Процессоры узлов NUMA
+ * @param p Параметры соединения
+ * @return pid рабочего процесса или -1 при ошибке fork
+ * @details Рабочий процесс выполняет обычный цикл Connection::conn на
+ * унаследованном сокете. Файлы трассы и захвата получают суффикс с номером
+ * процесса, передача сокета остается за супервизором
+ */
+static pid_t spawnWorker(size_t index, int server_socket, const std::vector<std::vector<int>>& nodes, const Params* p) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    signal(SIGCHLD, SIG_DFL);
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    wakePipe[0] = wakePipe[1] = -1;
+    if (nodes.size() > 1 && !pinToCpus(nodes[index % nodes.size()])) {
+        logError(p->logFile, "Ошибка привязки рабочего процесса к узлу NUMA: " + std::string(strerror(errno)));
+    }
+
+    Params worker = *p;
+    std::string suffix = "." + std::to_string(index);
+    worker.workers = 0;
+    worker.handoffPath.clear();
+    if (!worker.traceFile.empty()) {
+        worker.traceFile += suffix;
+    }
+    if (!worker.captureFile.empty()) {
+        worker.captureFile += suffix;
+    }
+    inheritedListener = server_socket;
+
+    int rc = 1;
+    try {
+        rc = Connection::conn(&worker);
+    } catch (const std::exception& e) {
+        logError(p->logFile, "Рабочий процесс " + std::to_string(index) + " завершен с ошибкой: " + e.what());
+    }
+    _exit(rc);
+}
+
+/**
+ * @brief Сбор завершившихся рабочих процессов
+ * @param slots Места рабочих процессов
+ * @param p Параметры соединения
+ * @details Для каждого завершившегося процесса назначается перезапуск с
+ * задержкой restartDelay()
+ */
+static void reapWorkers(std::vector<WorkerSlot>& slots, const Params* p) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            WorkerSlot& slot = slots[i];
+            if (slot.pid != pid) {
+                continue;
+            }
+            long uptime = std::chrono::duration_cast<std::chrono::milliseconds>(now - slot.started).count();
+            slot.pid = -1;
+            slot.delay = restartDelay(slot.delay, uptime);
+            slot.restartAt = now + std::chrono::milliseconds(slot.delay);
+            std::string reason = WIFSIGNALED(status) ? "сигнал " + std::to_string(WTERMSIG(status))
+                                                     : "код " + std::to_string(WEXITSTATUS(status));
+            logError(p->logFile, "Рабочий процесс " + std::to_string(i) + " (pid " + std::to_string(pid)
+                                 + ") завершился (" + reason + "), перезапуск через " + std::to_string(slot.delay) + " мс");
+        }
+    }
+}
+
+/**
+ * @brief Работа в режиме супервизора рабочих процессов
+ * @param p Параметры соединения
+ * @return Код завершения (0 - успех)
+ * @throw std::system_error при ошибках сетевых операций
+ * @details Супервизор создает слушающий сокет (или получает его от
+ * предыдущего процесса), загружает базу пользователей и ключ билетов и
+ * порождает Params::workers рабочих процессов, которые делят сокет и эти
+ * данные. На машинах с несколькими узлами NUMA рабочие процессы по очереди
+ * привязываются к процессорам узлов. Аварийно завершившийся процесс
+ * перезапускается с растущей задержкой, не затрагивая остальные. SIGTERM и
+ * SIGINT передаются рабочим процессам, которые завершают активные сессии
+ */
+static int supervise(const Params* p) {
+    stopRequested = false;
+    if (pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+        std::string errorMsg = "Ошибка создания канала: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onStopSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
+    sa.sa_handler = onChildSignal;
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, nullptr);
+
+    startTls(p);
+
+    // База пользователей и ключ билетов загружаются до fork: рабочие процессы
+    // делят страницы базы, а билет, выданный одним процессом, принимают все
+    std::string unused_password;
+    findUserInFile(p->inFileName, "", unused_password);
+    startTickets(p);
+
+    int server_socket = -1;
+    if (!p->handoffPath.empty()) {
+        server_socket = takeOverListener(p->handoffPath, p);
+        if (server_socket != -1) {
+            logError(p->logFile, "Получен слушающий сокет от предыдущего процесса");
+        }
+    }
+    if (server_socket == -1) {
+        server_socket = createListener(p);
+    }
+    fcntl(server_socket, F_SETFL, fcntl(server_socket, F_GETFL) | O_NONBLOCK);
+
+    int handoff_socket = -1;
+    bool handed_over = false;
+    if (!p->handoffPath.empty()) {
+        handoff_socket = openHandoffSocket(p->handoffPath, p);
+    }
+
+    std::vector<std::vector<int>> nodes = numaNodes();
+    logError(p->logFile, "Супервизор запущен на " + listenerName(p) + ", рабочих процессов: "
+                         + std::to_string(p->workers) + ", узлов NUMA: " + std::to_string(std::max<size_t>(nodes.size(), 1)));
+
+    std::vector<WorkerSlot> slots(p->workers);
+    for (WorkerSlot& slot : slots) {
+        slot.restartAt = std::chrono::steady_clock::now();
+    }
+
+    while (!stopRequested) {
+        auto now = std::chrono::steady_clock::now();
+        int timeout = -1;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            WorkerSlot& slot = slots[i];
+            if (slot.pid == -1 && slot.restartAt <= now) {
+                slot.pid = spawnWorker(i, server_socket, nodes, p);
+                if (slot.pid == -1) {
+                    logError(p->logFile, "Ошибка fork: " + std::string(strerror(errno)));
+                    slot.delay = restartDelay(slot.delay, 0);
+                    slot.restartAt = now + std::chrono::milliseconds(slot.delay);
+                } else {
+                    slot.started = now;
+                    std::string startMsg = "Рабочий процесс " + std::to_string(i) + " запущен (pid " + std::to_string(slot.pid);
+                    if (nodes.size() > 1) {
+                        startMsg += ", узел NUMA " + std::to_string(i % nodes.size());
+                    }
+                    logError(p->logFile, startMsg + ")");
+                }
+            }
+            if (slot.pid == -1) {
+                long wait = std::chrono::duration_cast<std::chrono::milliseconds>(slot.restartAt - now).count() + 1;
+                timeout = timeout == -1 ? static_cast<int>(wait) : std::min(timeout, static_cast<int>(wait));
+            }
+        }
+
+        pollfd fds[2] = {
+            {wakePipe[0], POLLIN, 0},
+            {handoff_socket, POLLIN, 0}
+        };
+        int ready = poll(fds, handoff_socket == -1 ? 1 : 2, timeout);
+        if (ready == -1 && errno != EINTR) {
+            std::string errorMsg = "Ошибка poll: " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            break;
+        }
+        char drain[64];
+        while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+        }
+
+        if (ready > 0 && handoff_socket != -1 && (fds[1].revents & POLLIN)) {
+            if (handOverListener(handoff_socket, server_socket, p)) {
+                handoff_socket = -1;
+                handed_over = true;
+                stopRequested = true;
+                break;
+            }
+        }
+
+        reapWorkers(slots, p);
+    }
+
+    logError(p->logFile, "Остановка рабочих процессов");
+    for (const WorkerSlot& slot : slots) {
+        if (slot.pid != -1) {
+            kill(slot.pid, SIGTERM);
+        }
+    }
+    for (const WorkerSlot& slot : slots) {
+        if (slot.pid != -1) {
+            while (waitpid(slot.pid, nullptr, 0) == -1 && errno == EINTR) {
+            }
+        }
+    }
+    signal(SIGCHLD, SIG_DFL);
+
+    if (handoff_socket != -1) {
+        close(handoff_socket);
+        unlink(p->handoffPath.c_str());
+    }
+    close(server_socket);
+    std::string socket_path = unixSocketPath(p->Address);
+    if (p->addressFamily == AF_UNIX && !handed_over && !socket_path.empty() && socket_path[0] != '@') {
+        unlink(socket_path.c_str());
+    }
+
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    wakePipe[0] = wakePipe[1] = -1;
+
+    logError(p->logFile, "Сервер остановлен");
+    return 0;
+}
+
+/**
+ * @brief Основной метод установки соединения и обработки клиентов
+ * @param p Указатель на параметры соединения
+ * @return Код завершения (0 - успех, 1 - ошибка)
+ * @throw std::system_error при ошибках сетевых операций
+ * @details Выполняет полный цикл работы сервера: создание сокета (или получение
+ * его от предыдущего процесса), привязка, прослушивание и прием клиентов до
+ * получения SIGTERM/SIGINT либо передачи сокета новому процессу, после чего
+ * дожидается завершения активных сессий. При Params::workers > 0 процесс
+ * становится супервизором рабочих процессов, каждый из которых выполняет
+ * этот же цикл
+ */
+int Connection::conn(const Params* p) {
+    // Инициализация генератора случайных чисел для соли; pid различает
+    // рабочие процессы, запущенные в одну секунду
+    srand(static_cast<unsigned int>(time(nullptr) ^ getpid()));
+
+    // Запись в закрытый клиентом сокет не должна завершать процесс
+    signal(SIGPIPE, SIG_IGN);
+
+    if (p->workers > 0) {
+        return supervise(p);
+    }
+
+    // Сигнал остановки мог прийти рабочему процессу сразу после fork
+    if (inheritedListener == -1) {
+        stopRequested = false;
+    }
+    if (pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+        std::string errorMsg = "Ошибка создания канала: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onStopSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
+
+    if (!p->traceFile.empty()) {
+        traceStart();
+    }
+    if (!p->captureFile.empty() && !captureStart(p->captureFile)) {
+        logError(p->logFile, "Не удалось открыть файл захвата: " + p->captureFile);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    startTls(p);
+
+    // Новый процесс загружает базу пользователей до перехвата сокета, чтобы
+    // первому клиенту не пришлось ждать ее разбора
+    std::string unused_password;
+    findUserInFile(p->inFileName, "", unused_password);
+    startTickets(p);
+
+    int server_socket = inheritedListener;
+    if (server_socket == -1 && !p->handoffPath.empty()) {
+        server_socket = takeOverListener(p->handoffPath, p);
+        if (server_socket != -1) {
+            logError(p->logFile, "Получен слушающий сокет от предыдущего процесса");
+        }
+    }
+    if (server_socket == -1) {
+        server_socket = createListener(p);
+    }
+    // Сокет может разделяться со старым процессом, поэтому accept не должен блокироваться
+    fcntl(server_socket, F_SETFL, fcntl(server_socket, F_GETFL) | O_NONBLOCK);
+
+    int handoff_socket = -1;
+    bool handed_over = false;
+    if (!p->handoffPath.empty()) {
+        handoff_socket = openHandoffSocket(p->handoffPath, p);
+    }
+
+    // В режиме сопрограмм клиентов принимает и обслуживает поток реактора
+    std::unique_ptr<Reactor> reactor;
+    std::thread reactor_thread;
+    if (p->sessionMode == "coro") {
+        reactor.reset(new Reactor());
+        reactor->setSpin(spinMicros(p));
+        Reactor* r = reactor.get();
+        reactor_thread = std::thread([r]() { r->run(); });
+        r->post([r, server_socket, p]() { r->spawn(acceptLoop(*r, server_socket, p)); });
+    }
+
+    // Логируем запуск сервера
+    logError(p->logFile, "Сервер запущен на " + listenerName(p));
+
+    while (!stopRequested) {
+        pollfd fds[3] = {
+            {reactor ? -1 : server_socket, POLLIN, 0},
+            {wakePipe[0], POLLIN, 0},
+            {handoff_socket, POLLIN, 0}
+        };
+        int ready = poll(fds, handoff_socket == -1 ? 2 : 3, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::string errorMsg = "Ошибка poll: " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            break;
+        }
+
+        if (handoff_socket != -1 && (fds[2].revents & POLLIN)) {
+            if (handOverListener(handoff_socket, server_socket, p)) {
+                handoff_socket = -1;
+                handed_over = true;
+                stopRequested = true;
+                break;
+            }
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        sockaddr_storage client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_socket = accept4(server_socket, reinterpret_cast<sockaddr*>(&client_addr), &client_len, SOCK_CLOEXEC);
+        if (client_socket == -1) {
+            // Соединение могло быть принято другим процессом, разделяющим сокет
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                std::string errorMsg = "Ошибка accept: " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+            }
+            continue;
+        }
+
+        // Логируем подключение клиента
+        std::string connectMsg = "Клиент подключен: " + peerName(client_addr, client_socket);
+        logError(p->logFile, connectMsg);
+        tuneSocket(client_socket, p);
+
+        startSession(client_socket, p);
+    }
+
+    logError(p->logFile, "Прием новых соединений остановлен");
+    if (reactor) {
+        // Прерываем прием соединений и ожидание следующих пачек
+        Reactor* r = reactor.get();
+        r->post([r, server_socket]() {
+            r->cancel(server_socket);
+            r->cancelIdle();
+        });
+    }
+    if (handoff_socket != -1) {
+        close(handoff_socket);
+        unlink(p->handoffPath.c_str());
+    }
+    close(server_socket);
+    // Файл Unix-сокета удаляется, только если сокет не передан новому процессу
+    // и принадлежит этому процессу, а не супервизору
+    std::string socket_path = unixSocketPath(p->Address);
+    if (p->addressFamily == AF_UNIX && !handed_over && inheritedListener == -1
+        && !socket_path.empty() && socket_path[0] != '@') {
+        unlink(socket_path.c_str());
+    }
+
+    drainSessions(p);
+    if (reactor) {
+        reactor->stop();
+        reactor_thread.join();
+    }
+
+    if (ResultCache* cache = resultCache(p)) {
+        logError(p->logFile, "Кэш результатов: попаданий " + std::to_string(cache->hits())
+                             + ", промахов " + std::to_string(cache->misses()));
+    }
+
+    if (!p->traceFile.empty()) {
+        long events = traceExport(p->traceFile);
+        if (events < 0) {
+            logError(p->logFile, "Не удалось записать трассу: " + p->traceFile);
+        } else {
+            logError(p->logFile, "Трасса записана: " + p->traceFile + " (интервалов: " + std::to_string(events) + ")");
+        }
+    }
+    if (!p->captureFile.empty()) {
+        logError(p->logFile, "Захват записан: " + p->captureFile + " (записей: " + std::to_string(captureStop()) + ")");
+    }
+
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    wakePipe[0] = wakePipe[1] = -1;
+
+    logError(p->logFile, "Сервер остановлен");
+    return 0;
+}
+
+/**
+ * @brief Обработка одной клиентской сессии
+ * @param client_socket Сокет подключенного клиента
+ * @param p Указатель на параметры соединения
+ * @return Код завершения (0 - успех, 1 - ошибка аутентификации)
+ * @details Выполняет аутентификацию клиента (логин, соль, хеш) и обработку
+ * пачки векторов. С параметром "session=keep" в приветствии клиент может
+ * прислать любое число пачек; сессию завершает количество векторов
+ * END_OF_SESSION или простой дольше Params::idleTimeout. Параметр "resume"
+ * запрашивает билет возобновления (ответ "OK:билет"), а "ticket=билет"
+ * позволяет пропустить обмен солью и хешем. Исключения сетевых
+ * операций перехватываются и логируются
+ */
+int Connection::session(int client_socket, const Params* p) {
+    uint64_t trace_id = traceSession();
+    TraceSpan session_span("session", trace_id);
+    CaptureSession capture(client_socket, trace_id);
+    // После рукопожатия ядро расшифровывает данные, и сессия читает открытый текст
+    if (serverTls && !acceptTls(client_socket, trace_id, p)) {
+        return 1;
+    }
+    try {
+        // Получаем логин от клиента
+        char buffer[BUFFER_SIZE];
+        ssize_t received_bytes;
+        {
+            TraceSpan span("recv_login", trace_id);
+            received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
+        }
+        if (received_bytes == -1) {
+            std::string errorMsg = "Ошибка recv (логин): " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            throw std::system_error(errno, std::generic_category());
+        }
+
+        buffer[received_bytes] = '\0';
+        captureInbound(client_socket, CaptureKind::Hello, &buffer[0], received_bytes);
+
+        Handshake hs;
+        hs.traceId = trace_id;
+        std::string error = beginHandshake(buffer, hs, p);
+        if (!error.empty()) {
+            safeSend(client_socket, error.c_str(), error.length(), p, "ошибка рукопожатия");
+            return 1;
+        }
+
+        std::string salt;
+        if (!hs.authenticated) {
+            // Генерируем и отправляем случайную соль
+            salt = generateSalt();
+            safeSend(client_socket, salt.c_str(), salt.length(), p, "соль");
+
+            // Получаем хеш от клиента
+            {
+                TraceSpan span("recv_hash", trace_id);
+                received_bytes = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
+            }
+            if (received_bytes == -1) {
+                std::string errorMsg = "Ошибка recv (хеш): " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+                throw std::system_error(errno, std::generic_category());
+            }
+
+            buffer[received_bytes] = '\0';
+            captureInbound(client_socket, CaptureKind::Hash, &buffer[0], received_bytes);
+        }
+
+        std::string response = finishHandshake(hs, salt, buffer, p);
+
+        // Клиент на том же узле может перенести обмен векторами в разделяемую
+        // память; дескрипторы приходят одним сообщением с ответом
+        std::unique_ptr<ShmChannel> channel;
+        if (hs.authenticated && helloOption(hs.options, "transport", "socket") == "shm") {
+            channel = openShm(client_socket, hs.encoding, p);
+        }
+        if (channel) {
+            if (!sendWithFds(client_socket, response.c_str(), response.length(), channel->clientFds(), 3)) {
+                std::string errorMsg = "Ошибка send (результат аутентификации): " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+                throw std::system_error(errno, std::generic_category());
+            }
+            logError(p->logFile, "Обмен векторами через разделяемую память для пользователя: " + hs.login);
+            shmSession(*channel, client_socket, *hs.kernel, trace_id, p);
+            logError(p->logFile, "Обработка завершена успешно");
+            return 0;
+        }
+        safeSend(client_socket, response.c_str(), response.length(), p, "результат аутентификации");
+
+        if (!hs.authenticated) {
+            return 1;
+        }
+
+        bool keep_alive = helloOption(hs.options, "session", "single") == "keep";
+        do {
+            // В постоянной сессии ждем следующую пачку не дольше Params::idleTimeout
+            if (keep_alive) {
+                TraceSpan span("wait_batch", trace_id);
+                if (!waitForBatch(client_socket, p)) {
+                    break;
+                }
+            }
+
+            // Получаем количество векторов
+            uint32_t vectors_count;
+            {
+                TraceSpan span("recv_count", trace_id);
+                safeRecv(client_socket, &vectors_count, sizeof(vectors_count), p, "количество векторов");
+            }
+
+            if (keep_alive && vectors_count == END_OF_SESSION) {
+                break;
+            }
+
+            processBatch(client_socket, vectors_count, *hs.kernel, hs.encoding, trace_id, p);
+        } while (keep_alive);
+
+        logError(p->logFile, "Обработка завершена успешно");
+
+    } catch (const std::exception& e) {
+        std::string errorMsg = "Исключение в обработке клиента: " + std::string(e.what());
+        logError(p->logFile, errorMsg);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Обработка одной клиентской сессии в сопрограмме
+ * @param reactor Реактор, в потоке которого выполняется сессия
+ * @param client_socket Сокет подключенного клиента
+ * @param p Указатель на параметры соединения
+ * @return Код завершения (0 - успех, 1 - ошибка аутентификации)
+ * @details Повторяет протокол session() построчно: вместо блокирующих
+ * recv/send сессия приостанавливается в co_await до готовности сокета, и
+ * тысячи ожидающих клиентов обслуживаются одним потоком реактора.
+ * Неблокирующий режим сокета включается здесь же, поэтому сессии безразлично,
+ * откуда пришел сокет: из asyncAccept, от прежнего процесса или из socketpair
+ */
+Task<int> Connection::asyncSession(Reactor& reactor, int client_socket, const Params* p) {
+    int flags = fcntl(client_socket, F_GETFL);
+    if (flags != -1 && !(flags & O_NONBLOCK)) {
+        fcntl(client_socket, F_SETFL, flags | O_NONBLOCK);
+    }
+    uint64_t trace_id = traceSession();
+    TraceSpan session_span("session", trace_id);
+    CaptureSession capture(client_socket, trace_id);
+    if (serverTls && !(co_await asyncAcceptTls(reactor, client_socket, trace_id, p))) {
+        co_return 1;
+    }
+    try {
+        // Получаем логин от клиента
+        std::string buffer(BUFFER_SIZE, '\0');
+        ssize_t received_bytes;
+        {
+            TraceSpan span("recv_login", trace_id);
+            received_bytes = co_await asyncRecv(reactor, client_socket, &buffer[0], BUFFER_SIZE - 1);
+        }
+        if (received_bytes == -1) {
+            std::string errorMsg = "Ошибка recv (логин): " + std::string(strerror(errno));
+            logError(p->logFile, errorMsg);
+            throw std::system_error(errno, std::generic_category());
+        }
+
+        buffer[received_bytes] = '\0';
+        captureInbound(client_socket, CaptureKind::Hello, &buffer[0], received_bytes);
+
+        Handshake hs;
+        hs.traceId = trace_id;
+        std::string error = beginHandshake(buffer.c_str(), hs, p);
+        if (!error.empty()) {
+            co_await asyncSendAll(reactor, client_socket, error.c_str(), error.length(), p, "ошибка рукопожатия");
+            co_return 1;
+        }
+
+        std::string salt;
+        if (!hs.authenticated) {
+            // Генерируем и отправляем случайную соль
+            salt = generateSalt();
+            co_await asyncSendAll(reactor, client_socket, salt.c_str(), salt.length(), p, "соль");
+
+            // Получаем хеш от клиента
+            {
+                TraceSpan span("recv_hash", trace_id);
+                received_bytes = co_await asyncRecv(reactor, client_socket, &buffer[0], BUFFER_SIZE - 1);
+            }
+            if (received_bytes == -1) {
+                std::string errorMsg = "Ошибка recv (хеш): " + std::string(strerror(errno));
+                logError(p->logFile, errorMsg);
+                throw std::system_error(errno, std::generic_category());
+            }
+
+            buffer[received_bytes] = '\0';
+            captureInbound(client_socket, CaptureKind::Hash, &buffer[0], received_bytes);
+        }
+
+        std::string response = finishHandshake(hs, salt, buffer.c_str(), p);
+        // Разделяемая память в режиме сопрограмм не предоставляется: ответ без дескрипторов
+        if (hs.authenticated && helloOption(hs.options, "transport", "socket") == "shm") {
+            logError(p->logFile, "Разделяемая память доступна только через Unix-сокет в режиме потоков");
+        }
+        co_await asyncSendAll(reactor, client_socket, response.c_str(), response.length(), p, "результат аутентификации");
+
+        if (!hs.authenticated) {
+            co_return 1;
+        }
+        // Буфер рукопожатия больше не нужен простаивающей сессии
+        std::string().swap(buffer);
+
+        bool keep_alive = helloOption(hs.options, "session", "single") == "keep";
+        do {
+            // В постоянной сессии ждем следующую пачку не дольше Params::idleTimeout
+            if (keep_alive) {
+                TraceSpan span("wait_batch", trace_id);
+                if (!co_await asyncWaitForBatch(reactor, client_socket, p)) {
+                    break;
+                }
+            }
+
+            // Получаем количество векторов
+            uint32_t vectors_count;
+            {
+                TraceSpan span("recv_count", trace_id);
+                co_await asyncRecvAll(reactor, client_socket, &vectors_count, sizeof(vectors_count), p, "количество векторов");
+            }
+
+            if (keep_alive && vectors_count == END_OF_SESSION) {
+                break;
+            }
+
+            co_await asyncProcessBatch(reactor, client_socket, vectors_count, *hs.kernel, hs.encoding, trace_id, p);
+        } while (keep_alive);
+
+        logError(p->logFile, "Обработка завершена успешно");
+
+    } catch (const std::exception& e) {
+        std::string errorMsg = "Исключение в обработке клиента: " + std::string(e.what());
+        logError(p->logFile, errorMsg);
+    }
+
+    co_return 0;
 }
@@ -12,6 +12,8 @@
 #include "errno.h"
 #include "crypto.h"
 #include "interface.h"
+#include "reactor.h"
+#include "reduce.h"
 #include <system_error>
 #include <netinet/in.h>
 #include <memory>
@@ -21,6 +23,14 @@
 #include <fstream>
 
 #define BUFFER_SIZE 1024 ///< Размер буфера для сетевых операций
+#define END_OF_SESSION 0xFFFFFFFFu ///< Количество векторов, завершающее постоянную сессию
+#define MAX_BATCH_VECTORS 1000 ///< Наибольшее количество векторов в пачке (большая пачка закрывает сессию)
+// Активное ожидание и SO_BUSY_POLL выключены, пока их выигрыш не измерен на
+// многопроцессорном узле; для измерения сервер собирается с -DLOW_LATENCY_SPIN_US=50
+#ifndef LOW_LATENCY_SPIN_US
+#define LOW_LATENCY_SPIN_US 0 ///< Активное ожидание данных перед блокировкой в профиле низкой задержки (мкс, 0 - выключено)
+#endif
+#define LOW_LATENCY_BUSY_POLL_US 50 ///< SO_BUSY_POLL в профиле низкой задержки (мкс, только при активном ожидании)
 
 using namespace std;
 
@@ -38,4 +48,33 @@ public:
      * @throw std::system_error при ошибках сетевых операций
      */
     static int conn(const Params* p);
+
+    /**
+     * @brief Обработка одной клиентской сессии
+     * @param client_socket Сокет подключенного клиента
+     * @param p Указатель на параметры соединения
+     * @return Код завершения (0 - успех, 1 - ошибка аутентификации)
+     * @note Сокет клиента не закрывается, это делает вызывающая сторона
+     */
+    static int session(int client_socket, const Params* p);
+
+    /**
+     * @brief Обработка одной клиентской сессии в сопрограмме
+     * @param reactor Реактор, в потоке которого выполняется сессия
+     * @param client_socket Сокет подключенного клиента
+     * @param p Указатель на параметры соединения
+     * @return Код завершения (0 - успех, 1 - ошибка аутентификации)
+     * @details Повторяет протокол session(), но вместо блокировки потока
+     * приостанавливается до готовности сокета; неблокирующий режим сокета
+     * сессия включает сама
+     * @note Сокет клиента не закрывается, это делает вызывающая сторона
+     */
+    static Task<int> asyncSession(Reactor& reactor, int client_socket, const Params* p);
+
+    /**
+     * @brief Запрос плавной остановки сервера
+     * @details Прекращает прием новых соединений; активные сессии
+     * завершают текущую пачку векторов в пределах Params::drainTimeout
+     */
+    static void requestStop();
 };
@@ -9,6 +9,8 @@
  */
 
 #include "crypto.h"
+#include <cryptopp/misc.h>
+#include <sstream>
 
 /**
  * @brief Вычисление хеша аутентификации
@@ -31,3 +33,80 @@ string auth(string salt, string pass){
 
     return hash;
 }
+
+/**
+ * @brief Генерация случайного ключа
+ * @param length Длина ключа в байтах
+ * @return Ключ из криптографически стойкого генератора
+ */
+string generateKey(size_t length){
+    CPP::AutoSeededRandomPool rng;
+    string key(length, '\0');
+    rng.GenerateBlock(reinterpret_cast<CPP::byte*>(&key[0]), key.size());
+    return key;
+}
+
+/**
+ * @brief Подпись HMAC-SHA256 в hex-формате
+ * @param key Ключ подписи
+ * @param data Подписываемые данные
+ * @return Подпись
+ */
+static string ticketMac(const string& key, const string& data){
+    CPP::HMAC<CPP::SHA256> hmac(reinterpret_cast<const CPP::byte*>(key.data()), key.size());
+    string mac;
+    CPP::StringSource(
+        data,
+        true,
+            new CPP::HashFilter(
+                hmac,
+                new CPP::HexEncoder(
+                    new CPP::StringSink(mac)))
+    );
+
+    return mac;
+}
+
+/**
+ * @brief Выдача билета возобновления сессии
+ * @param key Ключ подписи билетов
+ * @param login Логин пользователя
+ * @param expires Время окончания действия билета
+ * @return Билет вида "срок.подпись" (шестнадцатеричный)
+ */
+string issueTicket(const string& key, const string& login, time_t expires){
+    std::ostringstream ss;
+    ss << std::hex << static_cast<unsigned long long>(expires);
+    string expiry = ss.str();
+    return expiry + "." + ticketMac(key, expiry + "|" + login);
+}
+
+/**
+ * @brief Проверка билета возобновления сессии
+ * @param key Ключ подписи билетов
+ * @param login Логин, предъявленный вместе с билетом
+ * @param ticket Билет
+ * @param now Текущее время
+ * @return true если подпись верна и срок действия не истек
+ */
+bool verifyTicket(const string& key, const string& login, const string& ticket, time_t now){
+    size_t dot = ticket.find('.');
+    if (dot == string::npos || dot == 0 || dot > 16) {
+        return false;
+    }
+
+    string expiry = ticket.substr(0, dot);
+    if (expiry.find_first_not_of("0123456789abcdef") != string::npos) {
+        return false;
+    }
+    if (static_cast<time_t>(std::stoull(expiry, nullptr, 16)) < now) {
+        return false;
+    }
+
+    string mac = ticket.substr(dot + 1);
+    string expected = ticketMac(key, expiry + "|" + login);
+    // Сравнение за постоянное время, чтобы не раскрывать подпись по задержке
+    return mac.size() == expected.size()
+        && CPP::VerifyBufsEqual(reinterpret_cast<const CPP::byte*>(mac.data()),
+                                reinterpret_cast<const CPP::byte*>(expected.data()), mac.size());
+}
@@ -13,6 +13,8 @@
 #include <cryptopp/hex.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/sha.h>
+#include <cryptopp/hmac.h>
+#include <ctime>
 
 using namespace std;
 namespace CPP = CryptoPP;
@@ -24,3 +26,36 @@ namespace CPP = CryptoPP;
  * @return Хеш SHA-256 от соли и пароля
  */
 string auth(string salt, string pass);
+
+/**
+ * @brief Генерация случайного ключа
+ * @param length Длина ключа в байтах
+ * @return Ключ из криптографически стойкого генератора
+ */
+string generateKey(size_t length);
+
+/**
+ * @brief Выдача билета возобновления сессии
+ * @param key Ключ подписи билетов
+ * @param login Логин пользователя
+ * @param expires Время окончания действия билета
+ * @return Билет вида "срок.подпись" (шестнадцатеричный)
+ * @warning Билет - предъявительский токен: он не привязан к соединению, и
+ * перехвативший его до истечения срока войдет под этим логином без пароля,
+ * минуя обмен солью и хешем. Поэтому сервер выдает и принимает билеты только
+ * через TLS и Unix-сокеты, а на TCP без TLS всегда требует полную
+ * аутентификацию. Утечка ключа подписи позволяет выпускать билеты для любого
+ * логина, поэтому файл ключа должен быть доступен только серверу
+ */
+string issueTicket(const string& key, const string& login, time_t expires);
+
+/**
+ * @brief Проверка билета возобновления сессии
+ * @param key Ключ подписи билетов
+ * @param login Логин, предъявленный вместе с билетом
+ * @param ticket Билет
+ * @param now Текущее время
+ * @return true если подпись верна и срок действия не истек
+ * @details Проверка не требует хранения выданных билетов на сервере
+ */
+bool verifyTicket(const string& key, const string& login, const string& ticket, time_t now);
@@ -0,0 +1,244 @@
+/**
+ * @file handoff.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация передачи слушающего сокета между процессами
+ * @details Содержит функции отправки и получения дескрипторов через SCM_RIGHTS,
+ * используемые для перезапуска сервера без потери доступности порта
+ */
+
+#include "handoff.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Заполнение адреса Unix-сокета
+ * @param path Путь к сокету
+ * @param addr Адрес (выходной параметр)
+ * @return true если путь помещается в sun_path
+ */
+static bool makeUnixAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+/**
+ * @brief Передача данных вместе с файловыми дескрипторами одним сообщением
+ * @param unix_socket Подключенный Unix-сокет
+ * @param data Данные сообщения (не пустые)
+ * @param size Размер данных
+ * @param fds Передаваемые дескрипторы
+ * @param count Количество дескрипторов (не больше MAX_PASSED_FDS)
+ * @return true если сообщение отправлено целиком, false при ошибке
+ */
+bool sendWithFds(int unix_socket, const void* data, size_t size, const int* fds, size_t count) {
+    if (size == 0 || count == 0 || count > MAX_PASSED_FDS) {
+        errno = EINVAL;
+        return false;
+    }
+
+    iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+
+    char control[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+    std::memset(control, 0, sizeof(control));
+
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+    return sendmsg(unix_socket, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+/**
+ * @brief Передача файлового дескриптора через Unix-сокет
+ * @param unix_socket Подключенный Unix-сокет
+ * @param fd Передаваемый дескриптор
+ * @return true если дескриптор отправлен, false при ошибке
+ */
+bool sendFd(int unix_socket, int fd) {
+    char payload = 'F';
+    return sendWithFds(unix_socket, &payload, sizeof(payload), &fd, 1);
+}
+
+/**
+ * @brief Получение файлового дескриптора через Unix-сокет
+ * @param unix_socket Подключенный Unix-сокет
+ * @return Полученный дескриптор или -1 при ошибке
+ */
+int recvFd(int unix_socket) {
+    char payload;
+    iovec iov;
+    iov.iov_base = &payload;
+    iov.iov_len = sizeof(payload);
+
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(unix_socket, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+        return -1;
+    }
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        return -1;
+    }
+
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+/**
+ * @brief Освобождение пути для нового Unix-сокета
+ * @param path Путь к файлу сокета
+ * @return false, если по этому пути принимает соединения работающий процесс
+ */
+bool removeStaleSocket(const std::string& path) {
+    sockaddr_un addr;
+    struct stat st;
+    // Отсутствующий файл или файл другого типа не трогаем: bind сообщит об ошибке сам
+    if (!makeUnixAddress(path, addr) || lstat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        return true;
+    }
+
+    // Неблокирующее подключение не ждет, если очередь работающего сервера заполнена
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (probe == -1) {
+        return true;
+    }
+    int rc = connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    int error = errno;
+    close(probe);
+    if (rc == 0 || error == EAGAIN) {
+        return false;
+    }
+    if (error == ECONNREFUSED) {
+        unlink(path.c_str());
+    }
+    return true;
+}
+
+/**
+ * @brief Запрос слушающего сокета у работающего процесса
+ * @param path Путь к Unix-сокету передачи
+ * @param p Параметры соединения
+ * @return Слушающий сокет или -1, если старый процесс не найден
+ * @details Отсутствие старого процесса не является ошибкой: сервер просто
+ * создаст собственный слушающий сокет
+ */
+int takeOverListener(const std::string& path, const Params* p) {
+    sockaddr_un addr;
+    if (!makeUnixAddress(path, addr)) {
+        logError(p->logFile, "Слишком длинный путь сокета передачи: " + path);
+        return -1;
+    }
+
+    int unix_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unix_socket == -1) {
+        return -1;
+    }
+
+    if (connect(unix_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1) {
+        close(unix_socket);
+        return -1;
+    }
+
+    int fd = recvFd(unix_socket);
+    close(unix_socket);
+    if (fd == -1) {
+        logError(p->logFile, "Не удалось получить слушающий сокет от предыдущего процесса");
+    }
+    return fd;
+}
+
+/**
+ * @brief Создание Unix-сокета, ожидающего запрос на передачу
+ * @param path Путь к Unix-сокету передачи
+ * @param p Параметры соединения
+ * @return Слушающий Unix-сокет
+ * @throw std::system_error при ошибках создания сокета
+ * @warning Оставшийся от упавшего процесса файл сокета удаляется
+ */
+int openHandoffSocket(const std::string& path, const Params* p) {
+    sockaddr_un addr;
+    if (!makeUnixAddress(path, addr)) {
+        logError(p->logFile, "Слишком длинный путь сокета передачи: " + path);
+        throw std::system_error(ENAMETOOLONG, std::generic_category());
+    }
+
+    int unix_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unix_socket == -1) {
+        std::string errorMsg = "Ошибка создания сокета передачи: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    unlink(path.c_str());
+    // Передавать слушающий сокет разрешено только процессам того же пользователя
+    mode_t old_mask = umask(0077);
+    int rc = bind(unix_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    umask(old_mask);
+    if (rc == -1 || listen(unix_socket, 1) == -1) {
+        std::string errorMsg = "Ошибка bind сокета передачи: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        close(unix_socket);
+        throw std::system_error(errno, std::generic_category());
+    }
+    return unix_socket;
+}
+
+/**
+ * @brief Передача слушающего сокета новому процессу
+ * @param handoff_socket Unix-сокет передачи (закрывается при успешной передаче)
+ * @param server_socket Передаваемый слушающий сокет
+ * @param p Параметры соединения
+ * @return true если сокет передан и процесс должен завершить работу
+ * @details Файл сокета передачи не удаляется: новый процесс уже пересоздает
+ * его под тем же именем для следующего обновления
+ */
+bool handOverListener(int handoff_socket, int server_socket, const Params* p) {
+    int peer = accept4(handoff_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if (peer == -1) {
+        return false;
+    }
+
+    bool sent = sendFd(peer, server_socket);
+    close(peer);
+    if (!sent) {
+        std::string errorMsg = "Ошибка передачи слушающего сокета: " + std::string(strerror(errno));
+        logError(p->logFile, errorMsg);
+        return false;
+    }
+
+    close(handoff_socket);
+    logError(p->logFile, "Слушающий сокет передан новому процессу");
+    return true;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file handoff.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для передачи слушающего сокета между процессами
+ * @details Определяет функции для горячего обновления сервера: старый процесс
+ * передает слушающий сокет новому через Unix-сокет (SCM_RIGHTS)
+ */
+
+#pragma once
+#include "interface.h"
+#include <cstddef>
+#include <string>
+
+#define MAX_PASSED_FDS 4 ///< Максимум дескрипторов в одном сообщении SCM_RIGHTS
+
+/**
+ * @brief Передача данных вместе с файловыми дескрипторами одним сообщением
+ * @param unix_socket Подключенный Unix-сокет
+ * @param data Данные сообщения (не пустые)
+ * @param size Размер данных
+ * @param fds Передаваемые дескрипторы
+ * @param count Количество дескрипторов (не больше MAX_PASSED_FDS)
+ * @return true если сообщение отправлено целиком, false при ошибке
+ */
+bool sendWithFds(int unix_socket, const void* data, size_t size, const int* fds, size_t count);
+
+/**
+ * @brief Передача файлового дескриптора через Unix-сокет
+ * @param unix_socket Подключенный Unix-сокет
+ * @param fd Передаваемый дескриптор
+ * @return true если дескриптор отправлен, false при ошибке
+ */
+bool sendFd(int unix_socket, int fd);
+
+/**
+ * @brief Получение файлового дескриптора через Unix-сокет
+ * @param unix_socket Подключенный Unix-сокет
+ * @return Полученный дескриптор или -1 при ошибке
+ */
+int recvFd(int unix_socket);
+
+/**
+ * @brief Освобождение пути для нового Unix-сокета
+ * @param path Путь к файлу сокета
+ * @return false, если по этому пути принимает соединения работающий процесс
+ * @details Файл удаляется, только если это сокет и подключение к нему
+ * отвергнуто (ECONNREFUSED), то есть он остался от завершившегося процесса.
+ * Иначе второй экземпляр сервера молча отобрал бы путь у работающего
+ */
+bool removeStaleSocket(const std::string& path);
+
+/**
+ * @brief Запрос слушающего сокета у работающего процесса
+ * @param path Путь к Unix-сокету передачи
+ * @param p Параметры соединения
+ * @return Слушающий сокет или -1, если старый процесс не найден
+ */
+int takeOverListener(const std::string& path, const Params* p);
+
+/**
+ * @brief Создание Unix-сокета, ожидающего запрос на передачу
+ * @param path Путь к Unix-сокету передачи
+ * @param p Параметры соединения
+ * @return Слушающий Unix-сокет
+ * @throw std::system_error при ошибках создания сокета
+ * @warning Оставшийся от упавшего процесса файл сокета удаляется
+ */
+int openHandoffSocket(const std::string& path, const Params* p);
+
+/**
+ * @brief Передача слушающего сокета новому процессу
+ * @param handoff_socket Unix-сокет передачи (закрывается при успешной передаче)
+ * @param server_socket Передаваемый слушающий сокет
+ * @param p Параметры соединения
+ * @return true если сокет передан и процесс должен завершить работу
+ */
+bool handOverListener(int handoff_socket, int server_socket, const Params* p);
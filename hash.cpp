@@ -0,0 +1,213 @@
+/**
+ * @file hash.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация потоковых хешей
+ * @details Содержит потоковые варианты MurmurHash3 x64-128 (автор алгоритма -
+ * Austin Appleby) и SipHash-2-4 (авторы - J.-P. Aumasson и D. J. Bernstein)
+ */
+
+#include "hash.h"
+#include <algorithm>
+#include <cstring>
+
+static const uint64_t C1 = 0x87c37b91114253d5ull;   ///< Константа смешивания первой половины
+static const uint64_t C2 = 0x4cf5ad432745937full;   ///< Константа смешивания второй половины
+
+/**
+ * @brief Циклический сдвиг влево
+ */
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * @brief Финальное перемешивание 64-битного значения
+ */
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+/**
+ * @brief Конструктор
+ * @param seed Начальное значение хеша
+ */
+Hasher128::Hasher128(uint64_t seed) : h1(seed), h2(seed) {
+}
+
+/**
+ * @brief Обработка одного 16-байтного блока
+ * @param data Блок данных
+ */
+void Hasher128::block(const unsigned char* data) {
+    uint64_t k1, k2;
+    std::memcpy(&k1, data, sizeof(k1));
+    std::memcpy(&k2, data + 8, sizeof(k2));
+
+    k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+}
+
+/**
+ * @brief Добавление очередной порции данных
+ * @param data Данные
+ * @param size Размер данных
+ */
+void Hasher128::update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    total += size;
+
+    // Дополняем блок, оставшийся от предыдущей порции
+    if (tailSize > 0) {
+        size_t take = std::min(size, sizeof(tail) - tailSize);
+        std::memcpy(tail + tailSize, bytes, take);
+        tailSize += take;
+        bytes += take;
+        size -= take;
+        if (tailSize < sizeof(tail)) {
+            return;
+        }
+        block(tail);
+        tailSize = 0;
+    }
+
+    for (; size >= 16; bytes += 16, size -= 16) {
+        block(bytes);
+    }
+
+    std::memcpy(tail, bytes, size);
+    tailSize = size;
+}
+
+/**
+ * @brief Получение итогового значения
+ * @return Хеш всех добавленных данных
+ */
+Hash128 Hasher128::digest() const {
+    uint64_t a = h1;
+    uint64_t b = h2;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    for (size_t i = tailSize; i > 8; --i) {
+        k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+    }
+    if (tailSize > 8) {
+        k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; b ^= k2;
+    }
+    for (size_t i = std::min<size_t>(tailSize, 8); i > 0; --i) {
+        k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+    }
+    if (tailSize > 0) {
+        k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; a ^= k1;
+    }
+
+    a ^= total;
+    b ^= total;
+    a += b;
+    b += a;
+    a = fmix64(a);
+    b = fmix64(b);
+    a += b;
+    b += a;
+    return Hash128{a, b};
+}
+
+/**
+ * @brief Раунд SipHash
+ * @param v Состояние
+ */
+static inline void sipRound(uint64_t* v) {
+    v[0] += v[1]; v[1] = rotl64(v[1], 13); v[1] ^= v[0]; v[0] = rotl64(v[0], 32);
+    v[2] += v[3]; v[3] = rotl64(v[3], 16); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = rotl64(v[3], 21); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = rotl64(v[1], 17); v[1] ^= v[2]; v[2] = rotl64(v[2], 32);
+}
+
+/**
+ * @brief Конструктор
+ * @param k0 Младшая половина 128-битного ключа
+ * @param k1 Старшая половина 128-битного ключа
+ */
+SipHasher::SipHasher(uint64_t k0, uint64_t k1)
+    : v{k0 ^ 0x736f6d6570736575ull, k1 ^ 0x646f72616e646f6dull,
+        k0 ^ 0x6c7967656e657261ull, k1 ^ 0x7465646279746573ull} {
+}
+
+/**
+ * @brief Сжатие одного 8-байтного слова
+ * @param m Слово сообщения
+ */
+void SipHasher::compress(uint64_t m) {
+    v[3] ^= m;
+    sipRound(v);
+    sipRound(v);
+    v[0] ^= m;
+}
+
+/**
+ * @brief Добавление очередной порции данных
+ * @param data Данные
+ * @param size Размер данных
+ */
+void SipHasher::update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    total += size;
+
+    // Дополняем слово, оставшееся от предыдущей порции
+    if (tailSize > 0) {
+        size_t take = std::min(size, sizeof(tail) - tailSize);
+        std::memcpy(tail + tailSize, bytes, take);
+        tailSize += take;
+        bytes += take;
+        size -= take;
+        if (tailSize < sizeof(tail)) {
+            return;
+        }
+        uint64_t m;
+        std::memcpy(&m, tail, sizeof(m));
+        compress(m);
+        tailSize = 0;
+    }
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint64_t m;
+        std::memcpy(&m, bytes, sizeof(m));
+        compress(m);
+    }
+
+    std::memcpy(tail, bytes, size);
+    tailSize = size;
+}
+
+/**
+ * @brief Получение итогового значения
+ * @return SipHash всех добавленных данных
+ */
+uint64_t SipHasher::digest() const {
+    uint64_t state[4] = {v[0], v[1], v[2], v[3]};
+    uint64_t b = total << 56;
+    for (size_t i = 0; i < tailSize; ++i) {
+        b |= uint64_t(tail[i]) << (i * 8);
+    }
+
+    state[3] ^= b;
+    sipRound(state);
+    sipRound(state);
+    state[0] ^= b;
+    state[2] ^= 0xff;
+    for (int i = 0; i < 4; ++i) {
+        sipRound(state);
+    }
+    return state[0] ^ state[1] ^ state[2] ^ state[3];
+}
@@ -0,0 +1,111 @@
+/**
+ * @file hash.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для потоковых хешей
+ * @details Определяет класс Hasher128 (MurmurHash3 x64-128), который
+ * вычисляет хеш по частям по мере поступления данных из сокета, и класс
+ * SipHasher (ключевой SipHash-2-4) для проверки, которую нельзя подобрать
+ * без знания ключа
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct Hash128
+ * @brief 128-битное значение хеша
+ */
+struct Hash128 {
+    uint64_t lo;    ///< Младшие 64 бита
+    uint64_t hi;    ///< Старшие 64 бита
+
+    bool operator==(const Hash128& other) const {
+        return lo == other.lo && hi == other.hi;
+    }
+};
+
+/**
+ * @class Hasher128
+ * @brief Потоковое вычисление MurmurHash3 x64-128
+ * @details Результат не зависит от того, какими частями подавались данные
+ */
+class Hasher128 {
+public:
+    /**
+     * @brief Конструктор
+     * @param seed Начальное значение хеша
+     */
+    explicit Hasher128(uint64_t seed = 0);
+
+    /**
+     * @brief Добавление очередной порции данных
+     * @param data Данные
+     * @param size Размер данных
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Получение итогового значения
+     * @return Хеш всех добавленных данных
+     */
+    Hash128 digest() const;
+
+private:
+    /**
+     * @brief Обработка одного 16-байтного блока
+     * @param block Блок данных
+     */
+    void block(const unsigned char* block);
+
+    uint64_t h1;                ///< Первая половина состояния
+    uint64_t h2;                ///< Вторая половина состояния
+    unsigned char tail[16];     ///< Неполный блок между вызовами update
+    size_t tailSize = 0;        ///< Заполнение неполного блока
+    uint64_t total = 0;         ///< Общая длина данных
+};
+
+/**
+ * @class SipHasher
+ * @brief Потоковое вычисление SipHash-2-4 с 64-битным результатом
+ * @details В отличие от MurmurHash3, коллизии которого строятся при любом
+ * начальном значении, SipHash - псевдослучайная функция ключа: подобрать
+ * совпадение, не зная ключа, нельзя
+ */
+class SipHasher {
+public:
+    /**
+     * @brief Конструктор
+     * @param k0 Младшая половина 128-битного ключа
+     * @param k1 Старшая половина 128-битного ключа
+     */
+    SipHasher(uint64_t k0, uint64_t k1);
+
+    /**
+     * @brief Добавление очередной порции данных
+     * @param data Данные
+     * @param size Размер данных
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Получение итогового значения
+     * @return SipHash всех добавленных данных
+     */
+    uint64_t digest() const;
+
+private:
+    /**
+     * @brief Сжатие одного 8-байтного слова
+     * @param m Слово сообщения
+     */
+    void compress(uint64_t m);
+
+    uint64_t v[4];              ///< Состояние
+    unsigned char tail[8];      ///< Неполное слово между вызовами update
+    size_t tailSize = 0;        ///< Заполнение неполного слова
+    uint64_t total = 0;         ///< Общая длина данных
+};
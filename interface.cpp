@@ -9,6 +9,24 @@
  */
 
 #include "interface.h"
+#include <sys/socket.h>
+
+/**
+ * @brief Путь Unix-сокета из параметра адреса
+ * @param address Адрес вида "unix:путь", "unix:@имя" или "@имя"
+ * @return Путь сокета ("@имя" для абстрактного имени) или пустая строка,
+ * если адрес не относится к Unix-сокетам
+ */
+string unixSocketPath(const string& address)
+{
+    if (address.compare(0, 5, "unix:") == 0) {
+        return address.substr(5);
+    }
+    if (!address.empty() && address[0] == '@') {
+        return address;
+    }
+    return "";
+}
 
 /**
  * @brief Конструктор UserInterface
@@ -23,7 +41,23 @@ UserInterface::UserInterface() : desc("Allowed options")
     ("base,b", po::value<std::string>(&params.inFileName)->required(),"Set input data base name")
     ("journal,j", po::value<std::string>(&params.inFileJournal)->required(),"Set journal file name")
     ("port,p", po::value<int>(&params.Port)->required(), "Set port")
-    ("address,a", po::value<string>(&params.Address)->default_value("127.0.0.1"), "Set address");
+    ("address,a", po::value<string>(&params.Address)->default_value("127.0.0.1"), "Set address: IPv4, IPv6, unix:/path or @abstract-name")
+    ("idle-timeout", po::value<int>(&params.idleTimeout)->default_value(60), "Set keep-alive session idle timeout in seconds (0 - unlimited)")
+    ("ticket-ttl", po::value<int>(&params.ticketLifetime)->default_value(300), "Set session resumption ticket lifetime in seconds (0 - disabled; tickets are used only over TLS and Unix sockets)")
+    ("ticket-key", po::value<string>(&params.ticketKeyFile)->default_value(""), "Set shared ticket signing key file")
+    ("drain-timeout", po::value<int>(&params.drainTimeout)->default_value(30), "Set graceful shutdown timeout in seconds")
+    ("handoff", po::value<string>(&params.handoffPath)->default_value(""), "Set Unix socket path for listener handoff on restart")
+    ("max-vector", po::value<uint32_t>(&params.maxVectorSize)->default_value(10000), "Set maximum vector size in elements")
+    ("parallel-threshold", po::value<uint32_t>(&params.parallelThreshold)->default_value(262144), "Set vector size for parallel reduction (0 - disabled)")
+    ("reduce-threads", po::value<int>(&params.reduceThreads)->default_value(0), "Set parallel reduction threads (0 - all cores)")
+    ("cache-mb", po::value<int>(&params.cacheMemory)->default_value(0), "Set result cache memory budget in MB (0 - disabled)")
+    ("mode", po::value<string>(&params.sessionMode)->default_value("threads"), "Set session mode: threads or coro")
+    ("trace", po::value<string>(&params.traceFile)->default_value(""), "Record session phase timings to a Chrome trace JSON file")
+    ("capture", po::value<string>(&params.captureFile)->default_value(""), "Record inbound session traffic to a new binary capture file (mode 0600) for replay")
+    ("workers", po::value<int>(&params.workers)->default_value(0), "Set number of prefork worker processes under a supervisor (0 - single process)")
+    ("tls-cert", po::value<string>(&params.tlsCert)->default_value(""), "Set TLS certificate chain file (PEM) to encrypt TCP connections with kernel TLS")
+    ("tls-key", po::value<string>(&params.tlsKey)->default_value(""), "Set TLS private key file (PEM)")
+    ("low-latency", po::bool_switch(&params.lowLatency), "Use low-latency profile: TCP_NODELAY/QUICKACK (spin and SO_BUSY_POLL only in builds with LOW_LATENCY_SPIN_US)");
 }
 
 /**
@@ -45,6 +79,27 @@ bool UserInterface::Parser(int argc, const char** argv)
     return false;
     // присвоение значений по умолчанию и возбуждение исключений
     po::notify(vm);
+    if (params.sessionMode != "threads" && params.sessionMode != "coro") {
+        throw po::validation_error(po::validation_error::invalid_option_value, "mode", params.sessionMode);
+    }
+    if (params.workers < 0) {
+        throw po::validation_error(po::validation_error::invalid_option_value, "workers", std::to_string(params.workers));
+    }
+    // семейство адресов определяется синтаксисом --address
+    if (!unixSocketPath(params.Address).empty()) {
+        params.addressFamily = AF_UNIX;
+    } else if (params.Address.find(':') != string::npos) {
+        params.addressFamily = AF_INET6;
+    } else {
+        params.addressFamily = AF_INET;
+    }
+    // kTLS работает только поверх TCP; сертификат и ключ задаются вместе
+    if (params.tlsCert.empty() != params.tlsKey.empty()) {
+        throw po::validation_error(po::validation_error::invalid_option_value, "tls-key", params.tlsKey);
+    }
+    if (!params.tlsCert.empty() && params.addressFamily == AF_UNIX) {
+        throw po::validation_error(po::validation_error::invalid_option_value, "tls-cert", params.tlsCert);
+    }
     return true;
 }
 
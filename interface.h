@@ -10,6 +10,7 @@
 
 #pragma once
 #include <boost/program_options.hpp>
+#include <cstdint>
 #include <string>
 #include <sstream>
 
@@ -26,9 +27,34 @@ struct Params {
     string inFileData;      ///< Имя файла данных
     string logFile;         ///< Имя файла лога
     int Port;               ///< Порт сервера
-    string Address;         ///< Адрес сервера
+    string Address;         ///< Адрес сервера (IPv4, IPv6, "unix:путь" или "@имя")
+    int addressFamily;      ///< Семейство адресов (AF_INET, AF_INET6, AF_UNIX), определяется по Address
+    int idleTimeout;        ///< Время простоя постоянной сессии до закрытия (секунды, 0 - без ограничения)
+    int ticketLifetime;     ///< Срок действия билетов возобновления (секунды, 0 - билеты отключены)
+    string ticketKeyFile;   ///< Файл общего ключа подписи билетов (пусто - случайный ключ процесса)
+    int drainTimeout;       ///< Время ожидания завершения сессий при остановке (секунды)
+    string handoffPath;     ///< Путь к Unix-сокету передачи слушающего сокета
+    uint32_t maxVectorSize; ///< Максимальный размер вектора (элементов)
+    uint32_t parallelThreshold; ///< Размер вектора, начиная с которого свертка параллельная (0 - отключено)
+    int reduceThreads;      ///< Количество потоков параллельной свертки (0 - по числу ядер)
+    int cacheMemory;        ///< Объем памяти кэша результатов (МБ, 0 - кэш отключен)
+    string sessionMode;     ///< Режим обработки сессий: "threads" (поток на сессию) или "coro" (сопрограммы)
+    string traceFile;       ///< Файл трассы этапов сессий в формате Chrome trace-event (пусто - запись выключена)
+    string captureFile;     ///< Файл захвата входящего трафика сессий (пусто - захват выключен)
+    int workers;            ///< Количество рабочих процессов под супервизором (0 - один процесс)
+    string tlsCert;         ///< Файл сертификата TLS (пусто - соединения без шифрования)
+    string tlsKey;          ///< Файл закрытого ключа TLS
+    bool lowLatency;        ///< Профиль низкой задержки: TCP_NODELAY/QUICKACK (активный опрос и SO_BUSY_POLL - по LOW_LATENCY_SPIN_US)
 };
 
+/**
+ * @brief Путь Unix-сокета из параметра адреса
+ * @param address Адрес вида "unix:путь", "unix:@имя" или "@имя"
+ * @return Путь сокета ("@имя" для абстрактного имени) или пустая строка,
+ * если адрес не относится к Unix-сокетам
+ */
+string unixSocketPath(const string& address);
+
 /**
  * @class UserInterface
  * @brief Класс для обработки аргументов командной строки
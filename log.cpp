@@ -9,6 +9,8 @@
  */
 
 #include "log.h"
+#include "trace.h"
+#include <mutex>
 
 /**
  * @brief Получение текущего времени в формате строки
@@ -30,9 +32,14 @@ std::string getCurrentTime() {
  * @brief Запись ошибки в лог-файл
  * @param logFile Имя файла лога
  * @param errorMessage Сообщение об ошибке
- * @details Добавляет временную метку и записывает сообщение в файл
+ * @details Добавляет временную метку и записывает сообщение в файл.
+ * Запись сериализуется, так как сессии обрабатываются в разных потоках
  */
 void logError(const std::string& logFile, const std::string& errorMessage) {
+    // Интервал включает ожидание блокировки журнала другими потоками
+    TraceSpan span("logError", 0);
+    static std::mutex logMutex;
+    std::lock_guard<std::mutex> lock(logMutex);
     std::ofstream logStream(logFile, std::ios::app);
     if (logStream.is_open()) {
         logStream << "[" << getCurrentTime() << "] ERROR: " << errorMessage << std::endl;
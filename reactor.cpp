@@ -0,0 +1,349 @@
+/**
+ * @file reactor.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация реактора и асинхронных операций
+ * @details Содержит цикл событий на epoll с однократной регистрацией
+ * дескрипторов и таймаутами ожидания
+ */
+
+#include "reactor.h"
+#include <cerrno>
+#include <future>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+/**
+ * @brief Корневая сопрограмма для spawn(), освобождающая свой кадр по завершении
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+};
+
+/**
+ * @brief Выполнение задачи до завершения без ожидающей стороны
+ * @param task Задача
+ */
+static Detached runDetached(Task<void> task) {
+    try {
+        co_await task;
+    } catch (...) {
+        // Сессии обрабатывают и журналируют свои исключения сами
+    }
+}
+
+/**
+ * @brief Конструктор, создает epoll и eventfd для пробуждения
+ * @throw std::system_error при ошибках создания дескрипторов
+ */
+Reactor::Reactor() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        throw std::system_error(errno, std::generic_category());
+    }
+    eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventFd == -1) {
+        int err = errno;
+        close(epollFd);
+        throw std::system_error(err, std::generic_category());
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = eventFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev);
+}
+
+/**
+ * @brief Деструктор
+ */
+Reactor::~Reactor() {
+    close(eventFd);
+    close(epollFd);
+}
+
+/**
+ * @brief Регистрация ожидания в epoll
+ * @param awaiter Объект ожидания
+ * @param h Приостановленная сопрограмма
+ * @return false, если дескриптор нельзя отслеживать и сопрограмма продолжается сразу
+ */
+bool Reactor::arm(IoAwaiter& awaiter, std::coroutine_handle<> h) {
+    epoll_event ev{};
+    ev.events = awaiter.events | EPOLLONESHOT | EPOLLRDHUP;
+    ev.data.fd = awaiter.fd;
+    // После срабатывания EPOLLONESHOT дескриптор остается в epoll, поэтому сначала MOD
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, awaiter.fd, &ev) == -1
+        && epoll_ctl(epollFd, EPOLL_CTL_ADD, awaiter.fd, &ev) == -1) {
+        // Дескриптор нельзя отслеживать: сопрограмма сразу повторит операцию и получит ошибку
+        awaiter.result = WaitResult::Ready;
+        return false;
+    }
+
+    Waiter waiter{&awaiter, h, awaiter.timeoutMs >= 0, Clock::time_point()};
+    if (waiter.timed) {
+        waiter.deadline = Clock::now() + std::chrono::milliseconds(awaiter.timeoutMs);
+        timers.emplace(waiter.deadline, awaiter.fd);
+    }
+    waiters[awaiter.fd] = waiter;
+    return true;
+}
+
+/**
+ * @brief Возобновление сопрограммы, ожидающей на дескрипторе
+ * @param fd Дескриптор
+ * @param result Причина возобновления
+ */
+void Reactor::wake(int fd, WaitResult result) {
+    auto it = waiters.find(fd);
+    if (it == waiters.end()) {
+        return;
+    }
+    Waiter waiter = it->second;
+    waiters.erase(it);
+
+    if (waiter.timed) {
+        auto range = timers.equal_range(waiter.deadline);
+        for (auto t = range.first; t != range.second; ++t) {
+            if (t->second == fd) {
+                timers.erase(t);
+                break;
+            }
+        }
+    }
+    if (result != WaitResult::Ready) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    waiter.awaiter->result = result;
+    waiter.handle.resume();
+}
+
+/**
+ * @brief Запуск независимой сопрограммы
+ * @param task Сопрограмма; ее кадр освобождается по завершении
+ */
+void Reactor::spawn(Task<void> task) {
+    runDetached(std::move(task));
+}
+
+/**
+ * @brief Отмена ожидания на дескрипторе
+ * @param fd Дескриптор
+ */
+void Reactor::cancel(int fd) {
+    wake(fd, WaitResult::Cancelled);
+}
+
+/**
+ * @brief Отмена всех ожиданий между пачками
+ */
+void Reactor::cancelIdle() {
+    std::vector<int> idle;
+    for (const auto& entry : waiters) {
+        if (entry.second.awaiter->idle) {
+            idle.push_back(entry.first);
+        }
+    }
+    for (int fd : idle) {
+        wake(fd, WaitResult::Cancelled);
+    }
+}
+
+/**
+ * @brief Выполнение функции в потоке реактора
+ * @param fn Функция
+ */
+void Reactor::post(const std::function<void()>& fn) {
+    std::promise<void> done;
+    std::future<void> executed = done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        if (finished) {
+            fn();
+            return;
+        }
+        posted.push_back([&fn, &done]() {
+            fn();
+            done.set_value();
+        });
+    }
+    uint64_t one = 1;
+    ssize_t rc = write(eventFd, &one, sizeof(one));
+    (void)rc;
+    executed.wait();
+}
+
+/**
+ * @brief Остановка цикла событий
+ */
+void Reactor::stop() {
+    running = false;
+    uint64_t one = 1;
+    ssize_t rc = write(eventFd, &one, sizeof(one));
+    (void)rc;
+}
+
+/**
+ * @brief Таймаут epoll_wait до ближайшего истечения ожидания
+ * @return Таймаут в миллисекундах или -1
+ */
+int Reactor::nextTimeout() const {
+    if (timers.empty()) {
+        return -1;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(timers.begin()->first - Clock::now());
+    return left.count() > 0 ? static_cast<int>(left.count()) + 1 : 0;
+}
+
+/**
+ * @brief Цикл обработки событий до вызова stop()
+ */
+void Reactor::run() {
+    epoll_event events[64];
+
+    while (running) {
+        int ready = 0;
+        if (spinMicros > 0) {
+            // Опрос без блокировки избавляет от пробуждения потока, если
+            // событие приходит в течение spinMicros
+            Clock::time_point deadline = Clock::now() + std::chrono::microseconds(spinMicros);
+            do {
+                ready = epoll_wait(epollFd, events, 64, 0);
+            } while (ready == 0 && Clock::now() < deadline);
+        }
+        if (ready == 0) {
+            ready = epoll_wait(epollFd, events, 64, nextTimeout());
+        }
+        if (ready == -1 && errno != EINTR) {
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd != eventFd) {
+                wake(fd, WaitResult::Ready);
+                continue;
+            }
+
+            uint64_t counter;
+            ssize_t rc = read(eventFd, &counter, sizeof(counter));
+            (void)rc;
+            std::vector<std::function<void()>> batch;
+            {
+                std::lock_guard<std::mutex> lock(postedMutex);
+                batch.swap(posted);
+            }
+            for (auto& fn : batch) {
+                fn();
+            }
+        }
+
+        // Возобновляем сопрограммы с истекшим таймаутом
+        Clock::time_point now = Clock::now();
+        while (!timers.empty() && timers.begin()->first <= now) {
+            wake(timers.begin()->second, WaitResult::Timeout);
+        }
+    }
+
+    // Функции, поставленные в очередь до остановки, выполняются здесь
+    std::lock_guard<std::mutex> lock(postedMutex);
+    for (auto& fn : posted) {
+        fn();
+    }
+    posted.clear();
+    finished = true;
+}
+
+/**
+ * @brief Асинхронное получение данных
+ * @param reactor Реактор
+ * @param fd Сокет
+ * @param buffer Буфер
+ * @param size Размер буфера
+ * @param timeoutMs Таймаут ожидания (-1 - без ограничения)
+ * @return Результат как у recv(); при таймауте -1 и errno = ETIMEDOUT
+ */
+Task<ssize_t> asyncRecv(Reactor& reactor, int fd, void* buffer, size_t size, int timeoutMs) {
+    for (;;) {
+        ssize_t received = recv(fd, buffer, size, MSG_DONTWAIT);
+        if (received >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            co_return received;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+
+        Reactor::WaitResult result = co_await reactor.readable(fd, timeoutMs);
+        if (result != Reactor::WaitResult::Ready) {
+            errno = result == Reactor::WaitResult::Timeout ? ETIMEDOUT : ECANCELED;
+            co_return -1;
+        }
+    }
+}
+
+/**
+ * @brief Асинхронная отправка всех данных
+ * @param reactor Реактор
+ * @param fd Сокет
+ * @param data Данные
+ * @param size Размер данных
+ * @return Количество отправленных байт или -1 при ошибке (errno как у send())
+ */
+Task<ssize_t> asyncSend(Reactor& reactor, int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    size_t total_sent = 0;
+    while (total_sent < size) {
+        ssize_t sent = send(fd, bytes + total_sent, size - total_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent >= 0) {
+            total_sent += sent;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            co_return -1;
+        }
+        if (co_await reactor.writable(fd) != Reactor::WaitResult::Ready) {
+            errno = ECANCELED;
+            co_return -1;
+        }
+    }
+    co_return static_cast<ssize_t>(total_sent);
+}
+
+/**
+ * @brief Асинхронный прием соединения
+ * @param reactor Реактор
+ * @param listener Слушающий сокет
+ * @param addr Адрес клиента (выходной параметр, как у accept)
+ * @param len Длина адреса (входной и выходной параметр)
+ * @return Неблокирующий сокет клиента или -1 (errno = ECANCELED после отмены ожидания)
+ */
+Task<int> asyncAccept(Reactor& reactor, int listener, sockaddr* addr, socklen_t* len) {
+    for (;;) {
+        int client = accept4(listener, addr, len, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (client != -1 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            co_return client;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (co_await reactor.readable(listener) != Reactor::WaitResult::Ready) {
+            errno = ECANCELED;
+            co_return -1;
+        }
+    }
+}
@@ -0,0 +1,319 @@
+/**
+ * @file reactor.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для реактора и сопрограмм C++20
+ * @details Определяет тип сопрограммы Task, реактор на epoll и асинхронные
+ * операции asyncRecv, asyncSend и asyncAccept. Сессия, написанная на
+ * сопрограммах, читается так же последовательно, как блокирующая, но
+ * ожидает данные без отдельного стека потока
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename T = void> class Task;
+
+/**
+ * @brief Общая часть обещания сопрограммы Task
+ */
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;   ///< Ожидающая сопрограмма
+    std::exception_ptr error;               ///< Исключение, вышедшее из сопрограммы
+
+    /**
+     * @brief Ожидание при завершении: управление передается ожидающей сопрограмме
+     */
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+/**
+ * @brief Обещание сопрограммы, возвращающей значение
+ */
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    T value{};  ///< Результат сопрограммы
+
+    Task<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+    T result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(value);
+    }
+};
+
+/**
+ * @brief Обещание сопрограммы без результата
+ */
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * @class Task
+ * @brief Ленивая сопрограмма, запускаемая через co_await
+ * @tparam T Тип результата
+ * @details Исключения сопрограммы передаются ожидающему коду
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return handle.promise().result(); }
+
+private:
+    handle_type handle; ///< Кадр сопрограммы
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * @class Reactor
+ * @brief Однопоточный цикл событий на epoll
+ * @details Сопрограммы приостанавливаются до готовности дескриптора, истечения
+ * таймаута или отмены. Методы, кроме post() и stop(), вызываются только из
+ * потока реактора
+ */
+class Reactor {
+public:
+    /**
+     * @enum WaitResult
+     * @brief Причина возобновления ожидающей сопрограммы
+     */
+    enum class WaitResult {
+        Ready,      ///< Дескриптор готов
+        Timeout,    ///< Истек таймаут
+        Cancelled   ///< Ожидание отменено
+    };
+
+    /**
+     * @brief Ожидание готовности дескриптора
+     */
+    struct IoAwaiter {
+        Reactor& reactor;       ///< Реактор
+        int fd;                 ///< Дескриптор
+        uint32_t events;        ///< Ожидаемые события epoll
+        int timeoutMs;          ///< Таймаут (-1 - без ограничения)
+        bool idle;              ///< Ожидание между пачками, отменяемое cancelIdle()
+        WaitResult result = WaitResult::Ready; ///< Причина возобновления
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) { return reactor.arm(*this, h); }
+        WaitResult await_resume() const noexcept { return result; }
+    };
+
+    /**
+     * @brief Конструктор, создает epoll и eventfd для пробуждения
+     * @throw std::system_error при ошибках создания дескрипторов
+     */
+    Reactor();
+
+    /**
+     * @brief Деструктор
+     */
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * @brief Ожидание данных для чтения
+     * @param fd Дескриптор
+     * @param timeoutMs Таймаут в миллисекундах (-1 - без ограничения)
+     * @param idle Ожидание может быть прервано cancelIdle()
+     * @return Объект ожидания для co_await
+     */
+    IoAwaiter readable(int fd, int timeoutMs = -1, bool idle = false) {
+        return IoAwaiter{*this, fd, 0x001 /* EPOLLIN */, timeoutMs, idle};
+    }
+
+    /**
+     * @brief Ожидание возможности записи
+     * @param fd Дескриптор
+     * @return Объект ожидания для co_await
+     */
+    IoAwaiter writable(int fd) {
+        return IoAwaiter{*this, fd, 0x004 /* EPOLLOUT */, -1, false};
+    }
+
+    /**
+     * @brief Запуск независимой сопрограммы
+     * @param task Сопрограмма; ее кадр освобождается по завершении
+     */
+    void spawn(Task<void> task);
+
+    /**
+     * @brief Отмена ожидания на дескрипторе
+     * @param fd Дескриптор
+     */
+    void cancel(int fd);
+
+    /**
+     * @brief Отмена всех ожиданий между пачками
+     */
+    void cancelIdle();
+
+    /**
+     * @brief Выполнение функции в потоке реактора
+     * @param fn Функция
+     * @details Безопасно для вызова из любого потока; возвращает управление
+     * после выполнения функции. После завершения run() функция выполняется
+     * в вызывающем потоке
+     */
+    void post(const std::function<void()>& fn);
+
+    /**
+     * @brief Активное ожидание событий перед блокировкой
+     * @param micros Время опроса epoll без блокировки (мкс, 0 - сразу блокироваться)
+     * @details Вызывается до run()
+     */
+    void setSpin(int micros) {
+        spinMicros = micros;
+    }
+
+    /**
+     * @brief Цикл обработки событий до вызова stop()
+     */
+    void run();
+
+    /**
+     * @brief Остановка цикла событий
+     */
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Ожидающая сопрограмма
+     */
+    struct Waiter {
+        IoAwaiter* awaiter;             ///< Объект ожидания
+        std::coroutine_handle<> handle; ///< Сопрограмма
+        bool timed;                     ///< Есть ли таймаут
+        Clock::time_point deadline;     ///< Момент истечения таймаута
+    };
+
+    /**
+     * @brief Регистрация ожидания в epoll
+     * @param awaiter Объект ожидания
+     * @param h Приостановленная сопрограмма
+     * @return false, если дескриптор нельзя отслеживать и сопрограмма продолжается сразу
+     */
+    bool arm(IoAwaiter& awaiter, std::coroutine_handle<> h);
+
+    /**
+     * @brief Возобновление сопрограммы, ожидающей на дескрипторе
+     * @param fd Дескриптор
+     * @param result Причина возобновления
+     */
+    void wake(int fd, WaitResult result);
+
+    /**
+     * @brief Таймаут epoll_wait до ближайшего истечения ожидания
+     * @return Таймаут в миллисекундах или -1
+     */
+    int nextTimeout() const;
+
+    int epollFd;                                    ///< Дескриптор epoll
+    int eventFd;                                    ///< Дескриптор пробуждения из других потоков
+    std::unordered_map<int, Waiter> waiters;        ///< Ожидания по дескрипторам
+    std::multimap<Clock::time_point, int> timers;   ///< Таймауты ожиданий
+    std::mutex postedMutex;                         ///< Защита очереди функций
+    std::vector<std::function<void()>> posted;      ///< Функции для выполнения в потоке реактора
+    bool finished = false;                          ///< Цикл событий завершен (под postedMutex)
+    std::atomic<bool> running{true};                ///< Продолжать ли цикл событий
+    int spinMicros = 0;                             ///< Активное ожидание перед блокировкой в epoll_wait (мкс)
+};
+
+/**
+ * @brief Асинхронное получение данных
+ * @param reactor Реактор
+ * @param fd Сокет
+ * @param buffer Буфер
+ * @param size Размер буфера
+ * @param timeoutMs Таймаут ожидания (-1 - без ограничения)
+ * @return Результат как у recv(); при таймауте -1 и errno = ETIMEDOUT
+ */
+Task<ssize_t> asyncRecv(Reactor& reactor, int fd, void* buffer, size_t size, int timeoutMs = -1);
+
+/**
+ * @brief Асинхронная отправка всех данных
+ * @param reactor Реактор
+ * @param fd Сокет
+ * @param data Данные
+ * @param size Размер данных
+ * @return Количество отправленных байт или -1 при ошибке (errno как у send())
+ */
+Task<ssize_t> asyncSend(Reactor& reactor, int fd, const void* data, size_t size);
+
+/**
+ * @brief Асинхронный прием соединения
+ * @param reactor Реактор
+ * @param listener Слушающий сокет
+ * @param addr Адрес клиента (выходной параметр, как у accept)
+ * @param len Длина адреса (входной и выходной параметр)
+ * @return Неблокирующий сокет клиента или -1 (errno = ECANCELED после отмены ожидания)
+ * @details Сокет клиента сразу неблокирующий: сессия и TLS-рукопожатие в
+ * потоке реактора не должны ждать в read() данных медленного клиента
+ */
+Task<int> asyncAccept(Reactor& reactor, int listener, sockaddr* addr, socklen_t* len);
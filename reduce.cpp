@@ -0,0 +1,307 @@
+/**
+ * @file reduce.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация ядер свертки векторов
+ * @details Каждая комбинация операции, типа элементов и политики переполнения
+ * инстанцируется из шаблона Reducer и попадает в таблицу ядер
+ */
+
+#include "reduce.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Тип результата свертки для типа элементов
+ * @details uint16_t расширяется до uint32_t для совместимости с исходным протоколом
+ */
+template <typename T> struct WireType { using type = T; };
+template <> struct WireType<uint16_t> { using type = uint32_t; };
+
+/**
+ * @brief Тип двойной разрядности для проверки переполнения без ветвлений
+ */
+template <typename W> struct Wide;
+template <> struct Wide<uint32_t> { using type = uint64_t; };
+template <> struct Wide<int32_t> { using type = int64_t; };
+template <> struct Wide<uint64_t> { using type = unsigned __int128; };
+
+/**
+ * @brief Шаблон ядра свертки
+ * @tparam Op Операция
+ * @tparam T Тип элементов
+ * @tparam P Политика переполнения
+ */
+template <ReduceOp Op, typename T, OverflowPolicy P>
+struct Reducer {
+    /// Тип аккумулятора и результата
+    using Acc = std::conditional_t<Op == ReduceOp::Mean, double, typename WireType<T>::type>;
+
+    /// Насыщение знаковой суммы и произведения не ассоциативно: ограничение
+    /// на пути вверх не отменяется последующими отрицательными элементами.
+    /// При политике Error от порядка зависит и само переполнение
+    /// промежуточного результата (нулевой множитель в начале вектора его
+    /// исключает). Такие ядра сворачивают элементы строго по порядку
+    static constexpr bool ORDERED = std::is_integral_v<Acc> && P != OverflowPolicy::Wrap
+                                    && (Op == ReduceOp::Sum || Op == ReduceOp::Product)
+                                    && (std::is_signed_v<Acc> || (Op == ReduceOp::Product && P == OverflowPolicy::Error));
+
+    /// Количество независимых аккумуляторов во внутреннем цикле
+    static constexpr size_t LANES = 8;
+
+    /// Раскладка состояния
+    struct State {
+        Acc acc;            ///< Частичный результат
+        uint64_t count;     ///< Количество обработанных элементов
+        bool overflow;      ///< Было ли переполнение
+    };
+    static_assert(sizeof(State) <= sizeof(ReduceState), "State does not fit ReduceState");
+
+    /// Нейтральный элемент операции
+    static constexpr Acc identity() {
+        if constexpr (Op == ReduceOp::Product) {
+            return Acc(1);
+        } else if constexpr (Op == ReduceOp::Min) {
+            return std::numeric_limits<T>::has_infinity ? Acc(std::numeric_limits<T>::infinity())
+                                                        : Acc(std::numeric_limits<T>::max());
+        } else if constexpr (Op == ReduceOp::Max) {
+            return std::numeric_limits<T>::has_infinity ? Acc(-std::numeric_limits<T>::infinity())
+                                                        : Acc(std::numeric_limits<T>::lowest());
+        } else {
+            return Acc(0);
+        }
+    }
+
+    /// Один шаг свертки; переполнение накапливается в overflow без ветвлений
+    static inline Acc apply(Acc a, Acc b, bool& overflow) {
+        if constexpr (Op == ReduceOp::Min) {
+            return std::min(a, b);
+        } else if constexpr (Op == ReduceOp::Max) {
+            return std::max(a, b);
+        } else if constexpr (std::is_floating_point_v<Acc>) {
+            return Op == ReduceOp::Product ? a * b : a + b;
+        } else {
+            using D = typename Wide<Acc>::type;
+            const D r = Op == ReduceOp::Product ? D(a) * D(b) : D(a) + D(b);
+            const bool above = r > D(std::numeric_limits<Acc>::max());
+            bool below = false;
+            if constexpr (std::is_signed_v<Acc>) {
+                below = r < D(std::numeric_limits<Acc>::min());
+            }
+            overflow |= above | below;
+            if constexpr (P == OverflowPolicy::Wrap) {
+                return Acc(r);
+            } else {
+                const Acc clamped = below ? std::numeric_limits<Acc>::min() : std::numeric_limits<Acc>::max();
+                return (above | below) ? clamped : Acc(r);
+            }
+        }
+    }
+
+    static State& state(ReduceState& s) { return *std::launder(reinterpret_cast<State*>(s.raw)); }
+    static const State& state(const ReduceState& s) { return *std::launder(reinterpret_cast<const State*>(s.raw)); }
+
+    static void init(ReduceState& s) {
+        new (s.raw) State{identity(), 0, false};
+    }
+
+    static void feed(ReduceState& s, const void* data, size_t count) {
+        const T* elems = static_cast<const T*>(data);
+        if constexpr (ORDERED) {
+            // Единственный аккумулятор продолжает свертку предыдущих блоков
+            State& st = state(s);
+            bool overflow = false;
+            for (size_t i = 0; i < count; ++i) {
+                st.acc = apply(st.acc, Acc(elems[i]), overflow);
+            }
+            st.count += count;
+            st.overflow |= overflow;
+            return;
+        }
+
+        Acc lanes[LANES];
+        for (size_t k = 0; k < LANES; ++k) {
+            lanes[k] = identity();
+        }
+        bool overflow = false;
+
+        // Независимые аккумуляторы разрывают цепочку зависимостей и дают
+        // компилятору векторизовать цикл
+        size_t i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            for (size_t k = 0; k < LANES; ++k) {
+                lanes[k] = apply(lanes[k], Acc(elems[i + k]), overflow);
+            }
+        }
+        for (; i < count; ++i) {
+            lanes[0] = apply(lanes[0], Acc(elems[i]), overflow);
+        }
+
+        State& st = state(s);
+        for (size_t k = 0; k < LANES; ++k) {
+            st.acc = apply(st.acc, lanes[k], overflow);
+        }
+        st.count += count;
+        st.overflow |= overflow;
+    }
+
+    static void merge(ReduceState& s, const ReduceState& other) {
+        State& st = state(s);
+        const State& ot = state(other);
+        st.acc = apply(st.acc, ot.acc, st.overflow);
+        st.count += ot.count;
+        st.overflow |= ot.overflow;
+    }
+
+    static bool finish(const ReduceState& s, void* result) {
+        const State& st = state(s);
+        Acc value = st.acc;
+        if constexpr (Op == ReduceOp::Mean) {
+            value = st.count ? st.acc / double(st.count) : 0.0;
+        }
+        std::memcpy(result, &value, sizeof(value));
+        return st.overflow;
+    }
+
+    static constexpr ReduceKernel kernel(ElemType type) {
+        return ReduceKernel{Op, type, P, sizeof(T), sizeof(Acc), !ORDERED, &init, &feed, &merge, &finish};
+    }
+};
+
+/// Типы элементов в порядке перечисления ElemType
+using ElemTypes = std::tuple<uint16_t, int32_t, uint64_t, float, double>;
+
+constexpr size_t OP_COUNT = 5;      ///< Количество операций
+constexpr size_t TYPE_COUNT = 5;    ///< Количество типов элементов
+constexpr size_t POLICY_COUNT = 3;  ///< Количество политик переполнения
+
+/**
+ * @brief Ядро для позиции I таблицы (операция, тип, политика)
+ */
+template <size_t I>
+constexpr ReduceKernel kernelAt() {
+    constexpr ReduceOp op = static_cast<ReduceOp>(I / (TYPE_COUNT * POLICY_COUNT));
+    constexpr size_t type = (I / POLICY_COUNT) % TYPE_COUNT;
+    constexpr OverflowPolicy policy = static_cast<OverflowPolicy>(I % POLICY_COUNT);
+    using T = std::tuple_element_t<type, ElemTypes>;
+    return Reducer<op, T, policy>::kernel(static_cast<ElemType>(type));
+}
+
+template <size_t... I>
+constexpr std::array<ReduceKernel, sizeof...(I)> buildKernelTable(std::index_sequence<I...>) {
+    return {{kernelAt<I>()...}};
+}
+
+/// Таблица всех специализаций
+static constexpr auto kernelTable = buildKernelTable(std::make_index_sequence<OP_COUNT * TYPE_COUNT * POLICY_COUNT>());
+
+/**
+ * @brief Выбор ядра свертки
+ * @param op Операция
+ * @param type Тип элементов
+ * @param policy Политика переполнения
+ * @return Ядро из таблицы специализаций
+ */
+const ReduceKernel& selectKernel(ReduceOp op, ElemType type, OverflowPolicy policy) {
+    size_t index = (static_cast<size_t>(op) * TYPE_COUNT + static_cast<size_t>(type)) * POLICY_COUNT
+                   + static_cast<size_t>(policy);
+    return kernelTable[index];
+}
+
+/**
+ * @brief Поиск имени в списке
+ * @return Индекс имени или -1
+ */
+template <size_t N>
+static int findName(const std::string& name, const char* const (&names)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        if (name == names[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Выбор ядра свертки по именам из рукопожатия
+ * @param op Операция: product, sum, min, max, mean
+ * @param type Тип: uint16, int32, uint64, float, double
+ * @param policy Политика: saturate, wrap, error
+ * @return Ядро или nullptr, если имя не распознано
+ */
+const ReduceKernel* selectKernel(const std::string& op, const std::string& type, const std::string& policy) {
+    static const char* const opNames[] = {"product", "sum", "min", "max", "mean"};
+    static const char* const typeNames[] = {"uint16", "int32", "uint64", "float", "double"};
+    static const char* const policyNames[] = {"saturate", "wrap", "error"};
+
+    int o = findName(op, opNames);
+    int t = findName(type, typeNames);
+    int pol = findName(policy, policyNames);
+    if (o < 0 || t < 0 || pol < 0) {
+        return nullptr;
+    }
+    return &selectKernel(static_cast<ReduceOp>(o), static_cast<ElemType>(t), static_cast<OverflowPolicy>(pol));
+}
+
+/**
+ * @brief Свертка непрерывного блока элементов одним ядром
+ * @param kernel Ядро свертки
+ * @param data Элементы вектора
+ * @param count Количество элементов
+ * @param result Результат (выходной параметр)
+ * @return true если при свертке произошло переполнение
+ */
+bool reduceBlock(const ReduceKernel& kernel, const void* data, size_t count, ReduceResult& result) {
+    ReduceState state;
+    kernel.init(state);
+    kernel.feed(state, data, count);
+    result.size = kernel.resultSize;
+    return kernel.finish(state, result.bytes);
+}
+
+/**
+ * @brief Параллельная свертка большого блока элементов
+ * @param kernel Ядро свертки
+ * @param data Элементы вектора
+ * @param count Количество элементов
+ * @param pool Пул рабочих потоков
+ * @param result Результат (выходной параметр)
+ * @return true если при свертке произошло переполнение
+ */
+bool reduceParallel(const ReduceKernel& kernel, const void* data, size_t count, ThreadPool& pool, ReduceResult& result) {
+    if (!kernel.splittable) {
+        return reduceBlock(kernel, data, count, result);
+    }
+    // Вызывающий поток тоже выполняет свою часть работы
+    size_t chunks = std::max<size_t>(pool.size() + 1, 1);
+    size_t chunk_size = (count + chunks - 1) / chunks;
+    if (chunk_size == 0) {
+        return reduceBlock(kernel, data, count, result);
+    }
+    chunks = (count + chunk_size - 1) / chunk_size;
+
+    std::vector<ReduceState> partial(chunks);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    pool.run(chunks, [&](size_t chunk) {
+        size_t begin = chunk * chunk_size;
+        size_t end = std::min(count, begin + chunk_size);
+        kernel.init(partial[chunk]);
+        kernel.feed(partial[chunk], bytes + begin * kernel.elemSize, end - begin);
+    });
+
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        kernel.merge(partial[0], partial[chunk]);
+    }
+    result.size = kernel.resultSize;
+    return kernel.finish(partial[0], result.bytes);
+}
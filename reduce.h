@@ -0,0 +1,133 @@
+/**
+ * @file reduce.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для ядер свертки векторов
+ * @details Определяет операции свертки, типы элементов, политики переполнения
+ * и таблицу специализированных на этапе компиляции ядер
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class ThreadPool;
+
+/**
+ * @enum ReduceOp
+ * @brief Операция свертки вектора
+ */
+enum class ReduceOp {
+    Product,    ///< Произведение элементов
+    Sum,        ///< Сумма элементов
+    Min,        ///< Минимальный элемент
+    Max,        ///< Максимальный элемент
+    Mean        ///< Среднее арифметическое (результат double)
+};
+
+/**
+ * @enum ElemType
+ * @brief Тип элементов вектора
+ */
+enum class ElemType {
+    U16,        ///< uint16_t (результат uint32_t)
+    I32,        ///< int32_t
+    U64,        ///< uint64_t
+    F32,        ///< float
+    F64         ///< double
+};
+
+/**
+ * @enum OverflowPolicy
+ * @brief Поведение целочисленной свертки при переполнении
+ */
+enum class OverflowPolicy {
+    Saturate,   ///< Ограничение границами типа результата
+    Wrap,       ///< Перенос по модулю разрядности
+    Error       ///< Ошибка сессии
+};
+
+/**
+ * @struct ReduceState
+ * @brief Непрозрачное состояние свертки
+ * @details Конкретная раскладка определяется ядром; состояния ядра с
+ * ReduceKernel::splittable можно объединять, что позволяет сворачивать
+ * вектор по частям
+ */
+struct ReduceState {
+    alignas(16) unsigned char raw[32]; ///< Память под состояние ядра
+};
+
+/**
+ * @struct ReduceResult
+ * @brief Результат свертки в том виде, в котором он отправляется клиенту
+ */
+struct ReduceResult {
+    unsigned char bytes[8]; ///< Значение результата
+    size_t size;            ///< Размер результата в байтах
+};
+
+/**
+ * @struct ReduceKernel
+ * @brief Ядро свертки для конкретной комбинации операции, типа и политики
+ * @details Выбирается один раз на сессию; внутренний цикл feed не содержит
+ * ветвлений по операции, типу или политике
+ */
+struct ReduceKernel {
+    ReduceOp op;                ///< Операция
+    ElemType type;              ///< Тип элементов
+    OverflowPolicy policy;      ///< Политика переполнения
+    size_t elemSize;            ///< Размер элемента во входных данных
+    size_t resultSize;          ///< Размер результата
+    bool splittable;            ///< Результат не зависит от разбиения вектора на части (false, если насыщение или ошибка зависят от порядка элементов)
+    void (*init)(ReduceState& state);                                   ///< Начальное состояние
+    void (*feed)(ReduceState& state, const void* data, size_t count);   ///< Свертка блока элементов
+    void (*merge)(ReduceState& state, const ReduceState& other);        ///< Объединение частичных состояний
+    bool (*finish)(const ReduceState& state, void* result);             ///< Запись результата, true при переполнении
+};
+
+/**
+ * @brief Выбор ядра свертки
+ * @param op Операция
+ * @param type Тип элементов
+ * @param policy Политика переполнения
+ * @return Ядро из таблицы специализаций
+ */
+const ReduceKernel& selectKernel(ReduceOp op, ElemType type, OverflowPolicy policy);
+
+/**
+ * @brief Выбор ядра свертки по именам из рукопожатия
+ * @param op Операция: product, sum, min, max, mean
+ * @param type Тип: uint16, int32, uint64, float, double
+ * @param policy Политика: saturate, wrap, error
+ * @return Ядро или nullptr, если имя не распознано
+ */
+const ReduceKernel* selectKernel(const std::string& op, const std::string& type, const std::string& policy);
+
+/**
+ * @brief Свертка непрерывного блока элементов одним ядром
+ * @param kernel Ядро свертки
+ * @param data Элементы вектора
+ * @param count Количество элементов
+ * @param result Результат (выходной параметр)
+ * @return true если при свертке произошло переполнение
+ */
+bool reduceBlock(const ReduceKernel& kernel, const void* data, size_t count, ReduceResult& result);
+
+/**
+ * @brief Параллельная свертка большого блока элементов
+ * @param kernel Ядро свертки
+ * @param data Элементы вектора
+ * @param count Количество элементов
+ * @param pool Пул рабочих потоков
+ * @param result Результат (выходной параметр)
+ * @return true если при свертке произошло переполнение
+ * @details Блок делится на части по числу потоков пула; каждая часть
+ * сворачивается в собственное состояние (насыщение отслеживается по частям),
+ * после чего состояния объединяются по порядку. Ядра без
+ * ReduceKernel::splittable сворачивают блок целиком в вызывающем потоке
+ */
+bool reduceParallel(const ReduceKernel& kernel, const void* data, size_t count, ThreadPool& pool, ReduceResult& result);
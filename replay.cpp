@@ -0,0 +1,471 @@
+/**
+ * @file replay.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Инструмент воспроизведения захваченных сессий
+ * @details Читает файл, записанный сервером с параметром --capture, и
+ * повторяет сессии против запущенного сервера с исходными интервалами,
+ * ускорением в N раз или без пауз. На соль нового сервера отвечает заново
+ * по паролю из базы пользователей. Печатает пропускную способность и
+ * задержки, умеет сохранять итоги и сравнивать их с прошлым прогоном
+ */
+
+#include "capture.h"
+#include "crypto.h"
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace po = boost::program_options;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct ReplayOptions
+ * @brief Параметры воспроизведения
+ */
+struct ReplayOptions {
+    std::string captureFile;    ///< Файл захвата
+    std::string baseFile;       ///< База пользователей для ответа на соль
+    std::string address;        ///< Адрес сервера: IPv4, IPv6, unix:путь или @имя
+    int port;                   ///< Порт сервера
+    double speed;               ///< Ускорение (0 - без пауз)
+    int concurrency;            ///< Количество одновременно воспроизводимых сессий
+    std::string saveFile;       ///< Файл для сохранения итогов
+    std::string compareFile;    ///< Файл итогов прошлого прогона для сравнения
+};
+
+/**
+ * @struct ReplayStats
+ * @brief Итоги воспроизведения
+ */
+struct ReplayStats {
+    uint64_t sessions = 0;              ///< Воспроизведено сессий
+    uint64_t failed = 0;                ///< Сессий, прерванных ошибкой
+    uint64_t results = 0;               ///< Получено результатов векторов
+    uint64_t bytesSent = 0;             ///< Отправлено байт данных
+    std::vector<int64_t> latencyNs;     ///< Задержки результатов от последней отправки
+    std::vector<int64_t> handshakeNs;   ///< Время от подключения до ответа на аутентификацию
+
+    /**
+     * @brief Добавление итогов другого потока
+     * @param other Итоги
+     */
+    void merge(const ReplayStats& other) {
+        sessions += other.sessions;
+        failed += other.failed;
+        results += other.results;
+        bytesSent += other.bytesSent;
+        latencyNs.insert(latencyNs.end(), other.latencyNs.begin(), other.latencyNs.end());
+        handshakeNs.insert(handshakeNs.end(), other.handshakeNs.begin(), other.handshakeNs.end());
+    }
+};
+
+/**
+ * @brief Чтение паролей из базы пользователей
+ * @param path Файл базы ("логин:пароль" в строке)
+ * @return Пароли по логинам
+ */
+static std::map<std::string, std::string> loadPasswords(const std::string& path) {
+    std::map<std::string, std::string> passwords;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t pos = line.find(':');
+        if (pos != std::string::npos) {
+            passwords[line.substr(0, pos)] = line.substr(pos + 1);
+        }
+    }
+    return passwords;
+}
+
+/**
+ * @brief Приветствие для воспроизведения
+ * @param hello Захваченное приветствие
+ * @param login Логин клиента (выходной параметр)
+ * @return Приветствие без билета и разделяемой памяти
+ * @details Билет подписан ключом другого процесса, а разделяемая память
+ * недоступна по TCP, поэтому сессия всегда проходит полную аутентификацию
+ * и передает векторы через сокет. Обмен через разделяемую память всегда
+ * постоянный, поэтому для него добавляется "session=keep"
+ */
+static std::string replayHello(const std::string& hello, std::string& login) {
+    size_t pos = hello.find(':');
+    login = hello.substr(0, pos);
+    if (pos == std::string::npos) {
+        return hello;
+    }
+
+    std::string options;
+    bool shm = false;
+    bool session = false;
+    std::stringstream ss(hello.substr(pos + 1));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::string key = item.substr(0, item.find('='));
+        if (key == "transport") {
+            shm = item == "transport=shm";
+            continue;
+        }
+        if (key == "ticket" || key == "resume") {
+            continue;
+        }
+        session = session || key == "session";
+        options += (options.empty() ? "" : ",") + item;
+    }
+    if (shm && !session) {
+        options += (options.empty() ? "" : ",") + std::string("session=keep");
+    }
+    return options.empty() ? login : login + ":" + options;
+}
+
+/**
+ * @brief Подключение к серверу
+ * @param opts Параметры воспроизведения
+ * @return Сокет или -1
+ */
+static int connectServer(const ReplayOptions& opts) {
+    if (opts.address.rfind("unix:", 0) == 0 || opts.address.rfind("@", 0) == 0) {
+        std::string path = opts.address.rfind("unix:", 0) == 0 ? opts.address.substr(5) : opts.address;
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        std::memcpy(addr.sun_path, path.data(), path.size());
+        socklen_t len = sizeof(addr);
+        if (path[0] == '@') {
+            // Абстрактное имя: ведущий ноль вместо '@', длина без завершающего нуля
+            addr.sun_path[0] = '\0';
+            len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd != -1 && connect(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(opts.address.c_str(), std::to_string(opts.port).c_str(), &hints, &found) != 0) {
+        return -1;
+    }
+    int fd = socket(found->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd != -1 && connect(fd, found->ai_addr, found->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    // Данные отправляются целыми пачками, задержка Нейгла только исказила бы замер
+    int one = 1;
+    if (fd != -1) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+/**
+ * @brief Отправка всех данных
+ * @param fd Сокет
+ * @param data Данные
+ * @param size Размер
+ * @return false при ошибке
+ */
+static bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Получение данных фиксированного размера
+ * @param fd Сокет
+ * @param size Размер
+ * @return false при ошибке или закрытии соединения
+ */
+static bool recvExact(int fd, size_t size) {
+    char buffer[64];
+    while (size > 0) {
+        ssize_t received = recv(fd, buffer, std::min(size, sizeof(buffer)), 0);
+        if (received <= 0) {
+            return false;
+        }
+        size -= received;
+    }
+    return true;
+}
+
+/**
+ * @brief Воспроизведение одной сессии
+ * @param session Захваченная сессия
+ * @param opts Параметры воспроизведения
+ * @param passwords Пароли пользователей
+ * @param start Момент начала сессии по расписанию
+ * @param stats Итоги потока
+ * @return false, если сессия прервалась ошибкой
+ */
+static bool replaySession(const CapturedSession& session, const ReplayOptions& opts,
+                          const std::map<std::string, std::string>& passwords,
+                          Clock::time_point start, ReplayStats& stats) {
+    int fd = connectServer(opts);
+    if (fd == -1) {
+        return false;
+    }
+    // Зависший сервер не должен останавливать весь прогон
+    timeval timeout{30, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    Clock::time_point connected = Clock::now();
+    Clock::time_point lastSend = connected;
+    bool ok = true;
+    char reply[1024];
+
+    std::string pending;
+    const std::vector<CapturedRecord>& records = session.records;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const CapturedRecord& record = records[i];
+        if (!ok || record.kind == CaptureKind::End) {
+            break;
+        }
+        if (record.kind == CaptureKind::Hello) {
+            std::string login;
+            std::string hello = replayHello(record.data, login);
+            ssize_t received = -1;
+            if (sendAll(fd, hello.data(), hello.size())) {
+                received = recv(fd, reply, sizeof(reply) - 1, 0);
+            }
+            if (received <= 0) {
+                ok = false;
+                break;
+            }
+            std::string salt(reply, received);
+            if (salt.rfind("ERR", 0) == 0) {
+                break; // Отказ воспроизводится так же, как при захвате
+            }
+
+            // Отвечаем на новую соль; без пароля в базе повторяем захваченный хеш
+            std::string hash;
+            auto it = passwords.find(login);
+            if (it != passwords.end()) {
+                hash = auth(salt, it->second);
+            } else {
+                for (const CapturedRecord& r : session.records) {
+                    if (r.kind == CaptureKind::Hash) {
+                        hash = r.data;
+                    }
+                }
+            }
+            received = -1;
+            if (sendAll(fd, hash.data(), hash.size())) {
+                received = recv(fd, reply, sizeof(reply) - 1, 0);
+            }
+            ok = received >= 2 && std::memcmp(reply, "OK", 2) == 0;
+            stats.handshakeNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - connected).count());
+        } else if (record.kind == CaptureKind::Data) {
+            // Сервер принимает пачку по частям; подряд идущие части отправляются вместе
+            pending += record.data;
+            if (i + 1 < records.size() && records[i + 1].kind == CaptureKind::Data) {
+                continue;
+            }
+            if (opts.speed > 0) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<int64_t>(record.timeNs / opts.speed)));
+            }
+            ok = sendAll(fd, pending.data(), pending.size());
+            lastSend = Clock::now();
+            stats.bytesSent += pending.size();
+            pending.clear();
+        } else if (record.kind == CaptureKind::Result) {
+            ok = recvExact(fd, record.size);
+            stats.latencyNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - lastSend).count());
+            stats.results++;
+        }
+    }
+
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Перцентиль задержек
+ * @param values Отсортированные значения (нс)
+ * @param q Доля от 0 до 1
+ * @return Значение в микросекундах или 0 для пустого набора
+ */
+static double percentileUs(const std::vector<int64_t>& values, double q) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t idx = std::min(values.size() - 1, static_cast<size_t>(q * values.size()));
+    return values[idx] / 1000.0;
+}
+
+/**
+ * @brief Разбор параметров командной строки
+ * @param argc Количество аргументов
+ * @param argv Аргументы
+ * @param opts Параметры (выходной параметр)
+ * @return false, если нужно показать справку
+ */
+static bool parseOptions(int argc, const char** argv, ReplayOptions& opts) {
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help,h", "Show help")
+    ("capture,c", po::value<std::string>(&opts.captureFile)->required(), "Set capture file written by the server with --capture")
+    ("base,b", po::value<std::string>(&opts.baseFile)->default_value(""), "Set user base to answer salts")
+    ("address,a", po::value<std::string>(&opts.address)->default_value("127.0.0.1"), "Set server address: IPv4, IPv6, unix:/path or @abstract-name")
+    ("port,p", po::value<int>(&opts.port)->default_value(33333), "Set server port")
+    ("speed,s", po::value<double>(&opts.speed)->default_value(1.0), "Set replay speed multiplier (0 - as fast as possible)")
+    ("concurrency,n", po::value<int>(&opts.concurrency)->default_value(16), "Set number of sessions replayed at once")
+    ("save", po::value<std::string>(&opts.saveFile)->default_value(""), "Save summary to a file")
+    ("compare", po::value<std::string>(&opts.compareFile)->default_value(""), "Compare summary with a file saved by a previous run");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help") || argc == 1) {
+        std::cout << desc << std::endl;
+        return false;
+    }
+    po::notify(vm);
+    if (opts.speed < 0 || opts.concurrency < 1) {
+        throw po::validation_error(po::validation_error::invalid_option_value, "speed/concurrency");
+    }
+    return true;
+}
+
+/**
+ * @brief Главная функция инструмента воспроизведения
+ * @param argc Количество аргументов командной строки
+ * @param argv Массив аргументов командной строки
+ * @return Код завершения (0 - все сессии воспроизведены, 1 - ошибка)
+ */
+int main(int argc, const char** argv) {
+    ReplayOptions opts;
+    try {
+        if (!parseOptions(argc, argv, opts)) {
+            return 1;
+        }
+    } catch (const po::error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<CapturedSession> sessions;
+    bool truncated = false;
+    if (!captureLoad(opts.captureFile, sessions, &truncated)) {
+        std::cerr << "Не удалось прочитать файл захвата: " << opts.captureFile << std::endl;
+        return 1;
+    }
+    if (truncated) {
+        std::cerr << "Последняя запись захвата не дописана и отброшена: " << opts.captureFile << std::endl;
+    }
+    std::map<std::string, std::string> passwords = loadPasswords(opts.baseFile);
+
+    // Сессии запускаются по расписанию захвата; при нехватке потоков - с опозданием
+    std::atomic<size_t> next(0);
+    std::mutex statsMutex;
+    ReplayStats total;
+    Clock::time_point origin = Clock::now();
+    int64_t firstNs = sessions.empty() ? 0 : sessions.front().startNs;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < opts.concurrency; ++i) {
+        workers.emplace_back([&]() {
+            ReplayStats stats;
+            for (size_t idx = next++; idx < sessions.size(); idx = next++) {
+                Clock::time_point start = Clock::now();
+                if (opts.speed > 0) {
+                    start = origin + std::chrono::nanoseconds(static_cast<int64_t>((sessions[idx].startNs - firstNs) / opts.speed));
+                    std::this_thread::sleep_until(start);
+                }
+                stats.sessions++;
+                if (!replaySession(sessions[idx], opts, passwords, start, stats)) {
+                    stats.failed++;
+                }
+            }
+            std::lock_guard<std::mutex> lock(statsMutex);
+            total.merge(stats);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - origin).count();
+
+    std::sort(total.latencyNs.begin(), total.latencyNs.end());
+    std::sort(total.handshakeNs.begin(), total.handshakeNs.end());
+    std::map<std::string, double> summary = {
+        {"sessions", static_cast<double>(total.sessions)},
+        {"failed", static_cast<double>(total.failed)},
+        {"sessions_per_sec", total.sessions / seconds},
+        {"vectors_per_sec", total.results / seconds},
+        {"mb_per_sec", total.bytesSent / seconds / (1 << 20)},
+        {"latency_p50_us", percentileUs(total.latencyNs, 0.50)},
+        {"latency_p99_us", percentileUs(total.latencyNs, 0.99)},
+        {"latency_max_us", percentileUs(total.latencyNs, 1.0)},
+        {"handshake_p50_us", percentileUs(total.handshakeNs, 0.50)},
+        {"handshake_p99_us", percentileUs(total.handshakeNs, 0.99)}
+    };
+
+    std::map<std::string, double> baseline;
+    if (!opts.compareFile.empty()) {
+        std::ifstream file(opts.compareFile);
+        std::string key;
+        double value;
+        while (file >> key >> value) {
+            baseline[key] = value;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Время прогона: " << seconds << " с" << std::endl;
+    for (const auto& entry : summary) {
+        std::cout << std::left << std::setw(18) << entry.first << std::right << std::setw(14) << entry.second;
+        auto it = baseline.find(entry.first);
+        if (it != baseline.end()) {
+            std::cout << std::setw(14) << it->second;
+            if (it->second != 0) {
+                std::cout << std::showpos << std::setw(10) << (entry.second - it->second) / it->second * 100 << "%"
+                          << std::noshowpos;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    if (!opts.saveFile.empty()) {
+        std::ofstream file(opts.saveFile, std::ios::trunc);
+        file << std::setprecision(17);
+        for (const auto& entry : summary) {
+            file << entry.first << " " << entry.second << "\n";
+        }
+    }
+    return total.failed == 0 ? 0 : 1;
+}
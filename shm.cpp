@@ -0,0 +1,244 @@
+/**
+ * @file shm.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация транспорта через разделяемую память
+ * @details Содержит создание области memfd, доступ к кольцам и ожидание
+ * с засыпанием на eventfd
+ */
+
+#include "shm.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+/**
+ * @brief Количество байт, доступных читателю
+ * @throw std::system_error (EPROTO), если писатель выставил head за пределы кольца
+ */
+size_t ShmRing::readable() const {
+    uint64_t available = header->head.load(std::memory_order_acquire) - tail;
+    if (available > size) {
+        throw std::system_error(EPROTO, std::generic_category());
+    }
+    return static_cast<size_t>(available);
+}
+
+/**
+ * @brief Количество байт, доступных писателю
+ * @throw std::system_error (EPROTO), если читатель выставил tail за пределы кольца
+ */
+size_t ShmRing::writable() const {
+    uint64_t used = head - header->tail.load(std::memory_order_acquire);
+    if (used > size) {
+        throw std::system_error(EPROTO, std::generic_category());
+    }
+    return size - static_cast<size_t>(used);
+}
+
+/**
+ * @brief Начало непрерывного участка непрочитанных данных
+ * @param contiguous Длина участка до конца данных или кольца (выходной параметр)
+ * @return Указатель на данные
+ * @throw std::system_error (EPROTO), если писатель выставил head за пределы кольца
+ */
+const unsigned char* ShmRing::front(size_t& contiguous) const {
+    size_t offset = static_cast<size_t>(tail & (size - 1));
+    contiguous = std::min(readable(), size - offset);
+    return data + offset;
+}
+
+/**
+ * @brief Начало непрерывного свободного участка
+ * @param contiguous Длина участка до конца свободного места или кольца (выходной параметр)
+ * @return Указатель на место для записи
+ * @throw std::system_error (EPROTO), если читатель выставил tail за пределы кольца
+ */
+unsigned char* ShmRing::back(size_t& contiguous) const {
+    size_t offset = static_cast<size_t>(head & (size - 1));
+    contiguous = std::min(writable(), size - offset);
+    return data + offset;
+}
+
+/**
+ * @brief Создание области и дескрипторов пробуждения
+ * @param ringSize Размер данных каждого кольца (степень двойки, кратная странице)
+ * @throw std::system_error при ошибках memfd_create, ftruncate, fcntl, mmap или eventfd
+ * @details Размер memfd запечатывается до передачи дескриптора клиенту
+ */
+ShmChannel::ShmChannel(size_t ringSize)
+    : fds{-1, -1, -1}, mapping(MAP_FAILED), mappingSize(SHM_HEADER_SIZE + 2 * ringSize) {
+    if (ringSize == 0 || (ringSize & (ringSize - 1)) != 0 || ringSize % SHM_HEADER_SIZE != 0) {
+        throw std::system_error(EINVAL, std::generic_category());
+    }
+
+    fds[0] = memfd_create("server-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    fds[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    fds[2] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    // Клиент получает memfd на запись: без печатей он мог бы укоротить область,
+    // и следующее обращение сервера к кольцу завершило бы процесс по SIGBUS
+    if (fds[0] == -1 || fds[1] == -1 || fds[2] == -1 || ftruncate(fds[0], mappingSize) == -1
+        || fcntl(fds[0], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+        int err = errno;
+        release();
+        throw std::system_error(err, std::generic_category());
+    }
+
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    if (mapping == MAP_FAILED) {
+        int err = errno;
+        release();
+        throw std::system_error(err, std::generic_category());
+    }
+
+    // Новая область memfd заполнена нулями, поэтому атомарные поля уже имеют начальные значения
+    ShmHeader* header = new (mapping) ShmHeader();
+    header->magic = SHM_MAGIC;
+    header->ringSize = static_cast<uint32_t>(ringSize);
+
+    unsigned char* base = static_cast<unsigned char*>(mapping);
+    requests = ShmRing(&header->requests, base + SHM_HEADER_SIZE, ringSize);
+    responses = ShmRing(&header->responses, base + SHM_HEADER_SIZE + ringSize, ringSize);
+}
+
+/**
+ * @brief Деструктор, освобождает отображение и дескрипторы
+ */
+ShmChannel::~ShmChannel() {
+    release();
+}
+
+/**
+ * @brief Освобождение отображения и дескрипторов
+ */
+void ShmChannel::release() {
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, mappingSize);
+        mapping = MAP_FAILED;
+    }
+    for (int& fd : fds) {
+        if (fd != -1) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+/**
+ * @brief Общая часть ожидания: выставление флага, повторная проверка и сон на eventfd
+ * @param ready Проверка условия
+ * @param flag Флаг ожидания в заголовке кольца
+ * @param client_socket Сокет сессии
+ * @param stop_fd Дескриптор остановки или -1
+ * @param timeout_ms Таймаут или -1
+ * @return Результат ожидания
+ * @details Флаг выставляется до повторной проверки, а писатель проверяет его
+ * после публикации, поэтому пробуждение не теряется
+ */
+template <typename Ready>
+ShmChannel::Wait ShmChannel::wait(Ready ready, std::atomic<uint32_t>& flag, int client_socket, int stop_fd, int timeout_ms) {
+    for (;;) {
+        if (ready()) {
+            return Wait::Ready;
+        }
+        flag.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ready()) {
+            flag.store(0, std::memory_order_relaxed);
+            return Wait::Ready;
+        }
+
+        pollfd pfds[3] = {
+            {fds[1], POLLIN, 0},
+            {client_socket, POLLIN, 0},
+            {stop_fd, POLLIN, 0}
+        };
+        int rc = poll(pfds, 3, timeout_ms);
+        flag.store(0, std::memory_order_relaxed);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc == 0) {
+            return ready() ? Wait::Ready : Wait::Timeout;
+        }
+        if (pfds[0].revents & POLLIN) {
+            uint64_t counter;
+            ssize_t drained = read(fds[1], &counter, sizeof(counter));
+            (void)drained;
+        }
+        // Во время работы через кольца клиент ничего не пишет в сокет, поэтому
+        // его готовность к чтению означает закрытие
+        if (pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            return Wait::Closed;
+        }
+        if (pfds[2].revents & POLLIN) {
+            return Wait::Stopped;
+        }
+    }
+}
+
+/**
+ * @brief Ожидание данных в кольце запросов
+ * @param need Сколько байт должно быть доступно
+ * @param client_socket Сокет сессии (его закрытие прерывает ожидание)
+ * @param stop_fd Дескриптор, готовность которого означает остановку (-1 - не отслеживать)
+ * @param timeout_ms Таймаут (-1 - без ограничения)
+ * @return Результат ожидания
+ */
+ShmChannel::Wait ShmChannel::waitRequests(size_t need, int client_socket, int stop_fd, int timeout_ms) {
+    return wait([this, need]() { return requests.readable() >= need; },
+                requests.header->consumerWaiting, client_socket, stop_fd, timeout_ms);
+}
+
+/**
+ * @brief Ожидание места в кольце ответов
+ * @param need Сколько байт должно быть свободно
+ * @param client_socket Сокет сессии (его закрытие прерывает ожидание)
+ * @return Результат ожидания
+ */
+ShmChannel::Wait ShmChannel::waitResponseSpace(size_t need, int client_socket) {
+    return wait([this, need]() { return responses.writable() >= need; },
+                responses.header->producerWaiting, client_socket, -1, -1);
+}
+
+/**
+ * @brief Пробуждение клиента через его eventfd
+ */
+void ShmChannel::wakeClient() {
+    uint64_t one = 1;
+    ssize_t rc = write(fds[2], &one, sizeof(one));
+    (void)rc;
+}
+
+/**
+ * @brief Освобождение прочитанных запросов с пробуждением клиента при необходимости
+ * @param n Количество байт
+ */
+void ShmChannel::consumeRequests(size_t n) {
+    requests.consume(n);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (requests.header->producerWaiting.exchange(0, std::memory_order_relaxed)) {
+        wakeClient();
+    }
+}
+
+/**
+ * @brief Публикация ответов с пробуждением клиента при необходимости
+ * @param n Количество байт
+ */
+void ShmChannel::publishResponses(size_t n) {
+    responses.publish(n);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (responses.header->consumerWaiting.exchange(0, std::memory_order_relaxed)) {
+        wakeClient();
+    }
+}
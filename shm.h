@@ -0,0 +1,257 @@
+/**
+ * @file shm.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для транспорта через разделяемую память
+ * @details Определяет раскладку области memfd с двумя однонаправленными
+ * кольцами (запросы клиента и ответы сервера) и канал сервера поверх нее.
+ * Клиент на том же узле запрашивает транспорт параметром "transport=shm"
+ * в приветствии. Если транспорт предоставлен, ответ "OK" приходит одним
+ * сообщением вместе с тремя дескрипторами (SCM_RIGHTS): memfd области,
+ * eventfd пробуждения сервера и eventfd пробуждения клиента. Ответ без
+ * дескрипторов означает, что обмен продолжается через сокет
+ *
+ * Раскладка области (все смещения в байтах):
+ * - 0: ShmHeader (магическое число, размер кольца, заголовки колец);
+ * - SHM_HEADER_SIZE: данные кольца запросов (ShmHeader::ringSize байт);
+ * - SHM_HEADER_SIZE + ringSize: данные кольца ответов.
+ *
+ * Все записи в кольцах выровнены на 8 байт: количество векторов и размер
+ * вектора передаются 8-байтными записями (uint32_t и 4 байта заполнения),
+ * элементы вектора дополняются нулями до кратного 8 размера, каждый
+ * результат занимает 8 байт. Поэтому элементы никогда не разрезаются
+ * границей кольца и сворачиваются прямо в разделяемой памяти
+ *
+ * Ограничения одинаковы для обоих транспортов. Вектор больше
+ * Params::maxVectorSize и пачка больше MAX_BATCH_VECTORS векторов - ошибки
+ * протокола: сервер не читает элементы такого вектора, отправляет
+ * результаты предыдущих векторов пачки и закрывает сессию. Клиент, которому
+ * нужен больший вектор, должен разбить его сам
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define SHM_MAGIC 0x314D4853u           ///< Магическое число области ("SHM1")
+#define SHM_HEADER_SIZE 4096u           ///< Размер заголовка области
+#define SHM_RING_SIZE (1u << 20)        ///< Размер данных каждого кольца
+#define SHM_RECORD_ALIGN 8u             ///< Выравнивание записей в кольцах
+
+/**
+ * @struct ShmRingHeader
+ * @brief Заголовок кольца с одним писателем и одним читателем
+ * @details Счетчики head и tail монотонно растут; позиция в данных - остаток
+ * от деления на размер кольца. Писатель после публикации будит читателя,
+ * если тот выставил consumerWaiting; читатель после освобождения места
+ * будит писателя, если тот выставил producerWaiting
+ */
+struct ShmRingHeader {
+    alignas(64) std::atomic<uint64_t> head;             ///< Записано байт (изменяет писатель)
+    alignas(64) std::atomic<uint64_t> tail;             ///< Прочитано байт (изменяет читатель)
+    alignas(64) std::atomic<uint32_t> consumerWaiting;  ///< Читатель ждет данных
+    std::atomic<uint32_t> producerWaiting;              ///< Писатель ждет места
+};
+
+/**
+ * @struct ShmHeader
+ * @brief Заголовок области разделяемой памяти
+ */
+struct ShmHeader {
+    uint32_t magic;             ///< SHM_MAGIC
+    uint32_t ringSize;          ///< Размер данных каждого кольца (степень двойки)
+    ShmRingHeader requests;     ///< Кольцо запросов (пишет клиент)
+    ShmRingHeader responses;    ///< Кольцо ответов (пишет сервер)
+};
+
+static_assert(sizeof(ShmHeader) <= SHM_HEADER_SIZE, "заголовок не помещается в отведенную область");
+static_assert(offsetof(ShmHeader, requests) == 64 && offsetof(ShmHeader, responses) == 256,
+              "раскладка заголовка является частью протокола");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "кольцам нужны атомарные операции без блокировок");
+
+/**
+ * @class ShmRing
+ * @brief Доступ к одному кольцу области
+ * @details Заголовок кольца лежит в памяти, доступной клиенту на запись.
+ * Поэтому свои счетчики (tail читателя и head писателя) кольцо хранит в
+ * закрытых копиях и только публикует в заголовок, а счетчик другой стороны
+ * проверяет при каждой загрузке: между head и tail не может быть больше
+ * size байт
+ */
+class ShmRing {
+public:
+    /**
+     * @brief Конструктор пустого кольца
+     */
+    ShmRing() : header(nullptr), data(nullptr), size(0), head(0), tail(0) {}
+
+    /**
+     * @brief Конструктор
+     * @param header Заголовок кольца
+     * @param data Данные кольца
+     * @param size Размер данных (степень двойки)
+     */
+    ShmRing(ShmRingHeader* header, unsigned char* data, size_t size)
+        : header(header), data(data), size(size),
+          head(header->head.load(std::memory_order_relaxed)),
+          tail(header->tail.load(std::memory_order_relaxed)) {}
+
+    /**
+     * @brief Количество байт, доступных читателю
+     * @throw std::system_error (EPROTO), если писатель выставил head за пределы кольца
+     */
+    size_t readable() const;
+
+    /**
+     * @brief Количество байт, доступных писателю
+     * @throw std::system_error (EPROTO), если читатель выставил tail за пределы кольца
+     */
+    size_t writable() const;
+
+    /**
+     * @brief Начало непрерывного участка непрочитанных данных
+     * @param contiguous Длина участка до конца данных или кольца (выходной параметр)
+     * @return Указатель на данные
+     * @throw std::system_error (EPROTO), если писатель выставил head за пределы кольца
+     */
+    const unsigned char* front(size_t& contiguous) const;
+
+    /**
+     * @brief Освобождение прочитанных байт
+     * @param n Количество байт
+     */
+    void consume(size_t n) {
+        tail += n;
+        header->tail.store(tail, std::memory_order_release);
+    }
+
+    /**
+     * @brief Начало непрерывного свободного участка
+     * @param contiguous Длина участка до конца свободного места или кольца (выходной параметр)
+     * @return Указатель на место для записи
+     * @throw std::system_error (EPROTO), если читатель выставил tail за пределы кольца
+     */
+    unsigned char* back(size_t& contiguous) const;
+
+    /**
+     * @brief Публикация записанных байт
+     * @param n Количество байт
+     */
+    void publish(size_t n) {
+        head += n;
+        header->head.store(head, std::memory_order_release);
+    }
+
+    ShmRingHeader* header;  ///< Заголовок кольца
+    unsigned char* data;    ///< Данные кольца
+    size_t size;            ///< Размер данных
+
+private:
+    uint64_t head;          ///< Закрытая копия head (для писателя)
+    uint64_t tail;          ///< Закрытая копия tail (для читателя)
+};
+
+/**
+ * @class ShmChannel
+ * @brief Серверная сторона транспорта через разделяемую память
+ * @details Владеет областью memfd и обоими eventfd. Сервер читает кольцо
+ * запросов и пишет кольцо ответов
+ */
+class ShmChannel {
+public:
+    /**
+     * @enum Wait
+     * @brief Результат ожидания
+     */
+    enum class Wait {
+        Ready,      ///< Условие выполнено
+        Timeout,    ///< Истек таймаут
+        Closed,     ///< Клиент закрыл сокет сессии
+        Stopped     ///< Сервер останавливается
+    };
+
+    /**
+     * @brief Создание области и дескрипторов пробуждения
+     * @param ringSize Размер данных каждого кольца (степень двойки, кратная странице)
+     * @throw std::system_error при ошибках memfd_create, ftruncate, fcntl, mmap или eventfd
+     * @details Размер memfd запечатан (F_SEAL_SHRINK, F_SEAL_GROW, F_SEAL_SEAL):
+     * клиент не может изменить его через переданный дескриптор
+     */
+    explicit ShmChannel(size_t ringSize = SHM_RING_SIZE);
+
+    /**
+     * @brief Деструктор, освобождает отображение и дескрипторы
+     */
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    /**
+     * @brief Дескрипторы для передачи клиенту: memfd, eventfd сервера, eventfd клиента
+     */
+    const int* clientFds() const { return fds; }
+
+    /**
+     * @brief Ожидание данных в кольце запросов
+     * @param need Сколько байт должно быть доступно
+     * @param client_socket Сокет сессии (его закрытие прерывает ожидание)
+     * @param stop_fd Дескриптор, готовность которого означает остановку (-1 - не отслеживать)
+     * @param timeout_ms Таймаут (-1 - без ограничения)
+     * @return Результат ожидания
+     */
+    Wait waitRequests(size_t need, int client_socket, int stop_fd, int timeout_ms);
+
+    /**
+     * @brief Ожидание места в кольце ответов
+     * @param need Сколько байт должно быть свободно
+     * @param client_socket Сокет сессии (его закрытие прерывает ожидание)
+     * @return Результат ожидания
+     */
+    Wait waitResponseSpace(size_t need, int client_socket);
+
+    /**
+     * @brief Освобождение прочитанных запросов с пробуждением клиента при необходимости
+     * @param n Количество байт
+     */
+    void consumeRequests(size_t n);
+
+    /**
+     * @brief Публикация ответов с пробуждением клиента при необходимости
+     * @param n Количество байт
+     */
+    void publishResponses(size_t n);
+
+    ShmRing requests;   ///< Кольцо запросов (читает сервер)
+    ShmRing responses;  ///< Кольцо ответов (пишет сервер)
+
+private:
+    /**
+     * @brief Общая часть ожидания: выставление флага, повторная проверка и сон на eventfd
+     * @param ready Проверка условия
+     * @param flag Флаг ожидания в заголовке кольца
+     * @param client_socket Сокет сессии
+     * @param stop_fd Дескриптор остановки или -1
+     * @param timeout_ms Таймаут или -1
+     * @return Результат ожидания
+     */
+    template <typename Ready>
+    Wait wait(Ready ready, std::atomic<uint32_t>& flag, int client_socket, int stop_fd, int timeout_ms);
+
+    /**
+     * @brief Пробуждение клиента через его eventfd
+     */
+    void wakeClient();
+
+    /**
+     * @brief Освобождение отображения и дескрипторов
+     */
+    void release();
+
+    int fds[3];             ///< memfd, eventfd сервера, eventfd клиента
+    void* mapping;          ///< Отображение области
+    size_t mappingSize;     ///< Размер отображения
+};
@@ -0,0 +1,114 @@
+/**
+ * @file supervisor.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация вспомогательных функций супервизора рабочих процессов
+ * @details Топология NUMA читается из sysfs без зависимости от libnuma
+ */
+
+#include "supervisor.h"
+#include <algorithm>
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <sched.h>
+#include <sstream>
+
+/**
+ * @brief Разбор списка процессоров в формате sysfs
+ * @param text Список вида "0-3,8,10-11"
+ * @param cpus Номера процессоров (выходной параметр)
+ * @return false, если список пуст или некорректен
+ */
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item.erase(std::remove_if(item.begin(), item.end(), ::isspace), item.end());
+        if (item.empty()) {
+            continue;
+        }
+        size_t dash = item.find('-');
+        std::string head = item.substr(0, dash);
+        std::string tail = dash == std::string::npos ? head : item.substr(dash + 1);
+        if (head.empty() || tail.empty() || head.size() > 6 || tail.size() > 6
+            || (head + tail).find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        int first = std::stoi(head);
+        int last = std::stoi(tail);
+        if (last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return !cpus.empty();
+}
+
+/**
+ * @brief Процессоры узлов NUMA
+ * @return Списки процессоров по узлам; пустой вектор, если sysfs недоступен
+ */
+std::vector<std::vector<int>> numaNodes() {
+    static const std::string root = "/sys/devices/system/node";
+    std::map<int, std::vector<int>> nodes;
+    DIR* dir = opendir(root.c_str());
+    if (dir == nullptr) {
+        return {};
+    }
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, 4, "node") != 0 || name.size() == 4
+            || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+        std::ifstream file(root + "/" + name + "/cpulist");
+        std::string text;
+        std::vector<int> cpus;
+        if (std::getline(file, text) && parseCpuList(text, cpus)) {
+            nodes[std::stoi(name.substr(4))] = cpus;
+        }
+    }
+    closedir(dir);
+
+    std::vector<std::vector<int>> result;
+    for (auto& node : nodes) {
+        result.push_back(std::move(node.second));
+    }
+    return result;
+}
+
+/**
+ * @brief Привязка текущего процесса к процессорам
+ * @param cpus Номера процессоров
+ * @return false при ошибке sched_setaffinity
+ */
+bool pinToCpus(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief Задержка перед следующим перезапуском рабочего процесса
+ * @param previous Предыдущая задержка (мс, 0 - перезапусков не было)
+ * @param uptime Время работы завершившегося процесса (мс)
+ * @return Задержка (мс)
+ */
+long restartDelay(long previous, long uptime) {
+    if (previous <= 0 || uptime >= RESTART_STABLE_MS) {
+        return RESTART_DELAY_MIN_MS;
+    }
+    return std::min<long>(previous * 2, RESTART_DELAY_MAX_MS);
+}
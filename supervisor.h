@@ -0,0 +1,53 @@
+/**
+ * @file supervisor.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для вспомогательных функций супервизора рабочих процессов
+ * @details Определяет чтение топологии NUMA из sysfs, привязку процесса к
+ * процессорам узла и задержку перезапуска аварийно завершившихся рабочих
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+/// Начальная задержка перезапуска рабочего процесса (мс)
+#define RESTART_DELAY_MIN_MS 100
+/// Наибольшая задержка перезапуска рабочего процесса (мс)
+#define RESTART_DELAY_MAX_MS 10000
+/// Время работы, после которого процесс считается стабильным и задержка сбрасывается (мс)
+#define RESTART_STABLE_MS 10000
+
+/**
+ * @brief Разбор списка процессоров в формате sysfs
+ * @param text Список вида "0-3,8,10-11"
+ * @param cpus Номера процессоров (выходной параметр)
+ * @return false, если список пуст или некорректен
+ */
+bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+
+/**
+ * @brief Процессоры узлов NUMA
+ * @return Списки процессоров по узлам; пустой вектор, если sysfs недоступен
+ * @details Читает /sys/devices/system/node/node*\/cpulist; узлы без
+ * процессоров пропускаются
+ */
+std::vector<std::vector<int>> numaNodes();
+
+/**
+ * @brief Привязка текущего процесса к процессорам
+ * @param cpus Номера процессоров
+ * @return false при ошибке sched_setaffinity
+ */
+bool pinToCpus(const std::vector<int>& cpus);
+
+/**
+ * @brief Задержка перед следующим перезапуском рабочего процесса
+ * @param previous Предыдущая задержка (мс, 0 - перезапусков не было)
+ * @param uptime Время работы завершившегося процесса (мс)
+ * @return Задержка (мс): удваивается при повторных быстрых падениях
+ * до RESTART_DELAY_MAX_MS и сбрасывается после стабильной работы
+ */
+long restartDelay(long previous, long uptime);
@@ -0,0 +1,122 @@
+/**
+ * @file threadpool.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация пула рабочих потоков
+ * @details Содержит очередь заданий, из которой рабочие потоки разбирают
+ * пронумерованные задачи
+ */
+
+#include "threadpool.h"
+#include <atomic>
+
+/**
+ * @struct ThreadPool::Job
+ * @brief Задание из count пронумерованных задач
+ */
+struct ThreadPool::Job {
+    const std::function<void(size_t)>* task;    ///< Функция задачи
+    size_t count;                               ///< Количество задач
+    std::atomic<size_t> next{0};                ///< Номер следующей невыданной задачи
+    std::atomic<size_t> done{0};                ///< Количество выполненных задач
+    std::mutex doneMutex;                       ///< Защита ожидания завершения
+    std::condition_variable doneReady;          ///< Сигнал о выполнении всех задач
+};
+
+/**
+ * @brief Конструктор пула
+ * @param threads Количество рабочих потоков
+ */
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/**
+ * @brief Деструктор, дожидается завершения рабочих потоков
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Выполнение очередных задач задания
+ * @param job Задание
+ */
+void ThreadPool::drain(Job& job) {
+    for (;;) {
+        size_t index = job.next.fetch_add(1);
+        if (index >= job.count) {
+            return;
+        }
+        (*job.task)(index);
+        if (job.done.fetch_add(1) + 1 == job.count) {
+            std::lock_guard<std::mutex> lock(job.doneMutex);
+            job.doneReady.notify_all();
+        }
+    }
+}
+
+/**
+ * @brief Основной цикл рабочего потока
+ */
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping && queue.empty()) {
+                return;
+            }
+            job = queue.front();
+            // Задание снимается с очереди, когда все его задачи выданы
+            if (job->next.load() + 1 >= job->count) {
+                queue.pop_front();
+            }
+        }
+        drain(*job);
+    }
+}
+
+/**
+ * @brief Выполнение задач с номерами 0..count-1
+ * @param count Количество задач
+ * @param task Функция задачи, получает номер задачи
+ */
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+
+    if (count > 1 && !workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(job);
+        }
+        if (count > 2) {
+            queueReady.notify_all();
+        } else {
+            queueReady.notify_one();
+        }
+    }
+
+    drain(*job);
+
+    std::unique_lock<std::mutex> lock(job->doneMutex);
+    job->doneReady.wait(lock, [&job]() { return job->done.load() == job->count; });
+}
@@ -0,0 +1,80 @@
+/**
+ * @file threadpool.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для пула рабочих потоков
+ * @details Определяет класс ThreadPool для параллельной обработки частей
+ * больших векторов
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Пул потоков для параллельного выполнения пронумерованных задач
+ * @details Несколько сессий могут одновременно вызывать run(); вызывающий
+ * поток сам участвует в выполнении своих задач, поэтому run() не
+ * блокируется, даже если все рабочие потоки заняты
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Конструктор пула
+     * @param threads Количество рабочих потоков
+     */
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * @brief Деструктор, дожидается завершения рабочих потоков
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Выполнение задач с номерами 0..count-1
+     * @param count Количество задач
+     * @param task Функция задачи, получает номер задачи
+     * @details Возвращает управление после завершения всех задач
+     */
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Количество рабочих потоков
+     * @return Размер пула
+     */
+    size_t size() const {
+        return workers.size();
+    }
+
+private:
+    struct Job;
+
+    /**
+     * @brief Выполнение очередных задач задания
+     * @param job Задание
+     */
+    static void drain(Job& job);
+
+    /**
+     * @brief Основной цикл рабочего потока
+     */
+    void workerLoop();
+
+    std::vector<std::thread> workers;           ///< Рабочие потоки
+    std::deque<std::shared_ptr<Job>> queue;     ///< Задания, ожидающие выполнения
+    std::mutex queueMutex;                      ///< Защита очереди
+    std::condition_variable queueReady;         ///< Сигнал о новом задании
+    bool stopping = false;                      ///< Флаг завершения пула
+};
@@ -0,0 +1,184 @@
+/**
+ * @file tls.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация TLS с шифрованием записей в ядре (kTLS)
+ * @details Передачу ключей ядру выполняет OpenSSL (SSL_OP_ENABLE_KTLS);
+ * после рукопожатия проверяется, что kTLS включен для отправки и приема
+ */
+
+#include "tls.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+/**
+ * @brief Описание последней ошибки OpenSSL
+ * @return Текст ошибки из очереди OpenSSL (очередь очищается)
+ */
+static std::string opensslError() {
+    unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0) {
+        return "неизвестная ошибка";
+    }
+    char text[256];
+    ERR_error_string_n(code, text, sizeof(text));
+    return text;
+}
+
+/**
+ * @brief Поддерживает ли ядро kTLS
+ * @return false, если модуль tls ядра недоступен
+ */
+bool tlsKernelSupported() {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return false;
+    }
+    bool supported = setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) == 0 || errno == ENOTCONN;
+    close(fd);
+    return supported;
+}
+
+/**
+ * @brief Освобождение контекста
+ */
+TlsContext::~TlsContext() {
+    SSL_CTX_free(ctx);
+}
+
+/**
+ * @brief Загрузка сертификата и ключа
+ * @param certFile Файл сертификата (PEM, может содержать цепочку)
+ * @param keyFile Файл закрытого ключа (PEM)
+ * @param error Описание ошибки (выходной параметр)
+ * @return false, если файлы не загрузились или ключ не подходит к сертификату
+ */
+bool TlsContext::init(const std::string& certFile, const std::string& keyFile, std::string& error) {
+    SSL_CTX* c = SSL_CTX_new(TLS_server_method());
+    if (c == nullptr) {
+        error = opensslError();
+        return false;
+    }
+    SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+#if OPENSSL_VERSION_NUMBER < 0x30200000L
+    // До OpenSSL 3.2 прием через kTLS реализован только для TLS 1.2
+    SSL_CTX_set_max_proto_version(c, TLS1_2_VERSION);
+#endif
+    SSL_CTX_set_options(c, SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE);
+    SSL_CTX_set_cipher_list(c, "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                               "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384");
+    SSL_CTX_set_ciphersuites(c, "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384");
+    SSL_CTX_set_num_tickets(c, 0);
+    SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_OFF);
+
+    if (SSL_CTX_use_certificate_chain_file(c, certFile.c_str()) != 1
+        || SSL_CTX_use_PrivateKey_file(c, keyFile.c_str(), SSL_FILETYPE_PEM) != 1
+        || SSL_CTX_check_private_key(c) != 1) {
+        error = opensslError();
+        SSL_CTX_free(c);
+        return false;
+    }
+    SSL_CTX_free(ctx);
+    ctx = c;
+    return true;
+}
+
+/**
+ * @brief Подготовка рукопожатия
+ * @param context Серверный контекст
+ * @param socket Сокет TCP клиента
+ */
+TlsHandshake::TlsHandshake(const TlsContext& context, int socket) {
+    ssl = SSL_new(context.get());
+    if (ssl != nullptr && SSL_set_fd(ssl, socket) != 1) {
+        SSL_free(ssl);
+        ssl = nullptr;
+    }
+}
+
+/**
+ * @brief Освобождение объекта SSL; сокет и состояние kTLS сохраняются
+ */
+TlsHandshake::~TlsHandshake() {
+    SSL_free(ssl);
+}
+
+/**
+ * @brief Очередной шаг рукопожатия
+ * @return Состояние рукопожатия
+ */
+TlsStep TlsHandshake::step() {
+    if (ssl == nullptr) {
+        message = "не удалось создать объект SSL";
+        return TlsStep::Failed;
+    }
+    errno = 0;
+    int rc = SSL_accept(ssl);
+    if (rc != 1) {
+        switch (SSL_get_error(ssl, rc)) {
+            case SSL_ERROR_WANT_READ:
+                return TlsStep::WantRead;
+            case SSL_ERROR_WANT_WRITE:
+                return TlsStep::WantWrite;
+            case SSL_ERROR_SYSCALL:
+                message = errno != 0 ? std::string("ошибка сокета: ") + strerror(errno) : "соединение закрыто клиентом";
+                ERR_clear_error();
+                return TlsStep::Failed;
+            default:
+                message = opensslError();
+                return TlsStep::Failed;
+        }
+    }
+
+    // Дальше сокет используется без библиотеки, поэтому ядро должно
+    // шифровать оба направления
+    if (BIO_get_ktls_send(SSL_get_wbio(ssl)) != 1 || BIO_get_ktls_recv(SSL_get_rbio(ssl)) != 1) {
+        message = std::string("ядро не приняло ключи kTLS (") + SSL_get_version(ssl) + ", " + SSL_get_cipher_name(ssl) + ")";
+        return TlsStep::Failed;
+    }
+    return TlsStep::Done;
+}
+
+/**
+ * @brief Рукопожатие на блокирующем сокете
+ * @param timeoutMs Наибольшее время всего рукопожатия (мс)
+ * @return TlsStep::Done или TlsStep::Failed
+ */
+TlsStep TlsHandshake::run(int timeoutMs) {
+    int socket = ssl != nullptr ? SSL_get_fd(ssl) : -1;
+    int flags = socket != -1 ? fcntl(socket, F_GETFL) : -1;
+    if (flags != -1 && !(flags & O_NONBLOCK)) {
+        fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    TlsStep result;
+    while ((result = step()) == TlsStep::WantRead || result == TlsStep::WantWrite) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        pollfd pfd = {socket, static_cast<short>(result == TlsStep::WantRead ? POLLIN : POLLOUT), 0};
+        if (left <= 0 || poll(&pfd, 1, static_cast<int>(left)) <= 0) {
+            message = "истекло время рукопожатия";
+            result = TlsStep::Failed;
+            break;
+        }
+    }
+    if (flags != -1 && !(flags & O_NONBLOCK)) {
+        fcntl(socket, F_SETFL, flags);
+    }
+    return result;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file tls.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для TLS с шифрованием записей в ядре (kTLS)
+ * @details Рукопожатие выполняет OpenSSL, после чего ключи сессии
+ * передаются ядру (TCP_ULP "tls"), а объект SSL освобождается. Дальше сокет
+ * используется обычными recv/send: ядро шифрует и расшифровывает записи без
+ * копирования через буферы библиотеки. Соединение, для которого ядро не
+ * приняло ключи в обоих направлениях, закрывается, а не продолжается
+ * открытым текстом
+ */
+
+#pragma once
+#include <string>
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_st SSL;
+
+#define TLS_HANDSHAKE_TIMEOUT_MS 10000  ///< Наибольшее время TLS-рукопожатия (мс)
+
+/**
+ * @brief Поддерживает ли ядро kTLS
+ * @return false, если модуль tls ядра недоступен
+ * @details Проверяется установкой TCP_ULP на неподключенный сокет: при
+ * наличии модуля ядро отвечает ENOTCONN, при отсутствии - ENOENT
+ */
+bool tlsKernelSupported();
+
+/**
+ * @class TlsContext
+ * @brief Серверный контекст TLS с сертификатом и ключом
+ * @details Разрешены TLS 1.2 и выше с шифрами AES-GCM, которые ядро умеет
+ * выполнять; билеты сессий TLS отключены, чтобы после рукопожатия сервер
+ * не отправлял сообщений через библиотеку
+ */
+class TlsContext {
+public:
+    TlsContext() = default;
+
+    /**
+     * @brief Освобождение контекста
+     */
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    /**
+     * @brief Загрузка сертификата и ключа
+     * @param certFile Файл сертификата (PEM, может содержать цепочку)
+     * @param keyFile Файл закрытого ключа (PEM)
+     * @param error Описание ошибки (выходной параметр)
+     * @return false, если файлы не загрузились или ключ не подходит к сертификату
+     */
+    bool init(const std::string& certFile, const std::string& keyFile, std::string& error);
+
+    /**
+     * @brief Контекст OpenSSL
+     * @return Указатель на SSL_CTX или nullptr до init()
+     */
+    SSL_CTX* get() const {
+        return ctx;
+    }
+
+private:
+    SSL_CTX* ctx = nullptr;     ///< Контекст OpenSSL
+};
+
+/**
+ * @enum TlsStep
+ * @brief Состояние рукопожатия после очередного шага
+ */
+enum class TlsStep {
+    Done,       ///< Рукопожатие завершено, ключи переданы ядру
+    WantRead,   ///< Нужно дождаться данных от клиента
+    WantWrite,  ///< Нужно дождаться возможности записи
+    Failed      ///< Ошибка рукопожатия или kTLS не включен
+};
+
+/**
+ * @class TlsHandshake
+ * @brief Серверное рукопожатие TLS на сокете
+ * @details Работает как с блокирующими, так и с неблокирующими сокетами:
+ * step() повторяется, пока не вернет Done или Failed
+ */
+class TlsHandshake {
+public:
+    /**
+     * @brief Подготовка рукопожатия
+     * @param context Серверный контекст
+     * @param socket Сокет TCP клиента
+     */
+    TlsHandshake(const TlsContext& context, int socket);
+
+    /**
+     * @brief Освобождение объекта SSL; сокет и состояние kTLS сохраняются
+     */
+    ~TlsHandshake();
+
+    TlsHandshake(const TlsHandshake&) = delete;
+    TlsHandshake& operator=(const TlsHandshake&) = delete;
+
+    /**
+     * @brief Очередной шаг рукопожатия
+     * @return Состояние рукопожатия
+     */
+    TlsStep step();
+
+    /**
+     * @brief Рукопожатие на блокирующем сокете
+     * @param timeoutMs Наибольшее время всего рукопожатия (мс)
+     * @return TlsStep::Done или TlsStep::Failed
+     * @details На время рукопожатия сокет переводится в неблокирующий режим:
+     * иначе SSL_accept ждал бы в read() остаток частично присланной записи
+     * без ограничения времени. Ограничение действует на рукопожатие целиком,
+     * а не на каждое ожидание, поэтому присылающий по байту клиент его не продлит
+     */
+    TlsStep run(int timeoutMs);
+
+    /**
+     * @brief Описание ошибки после TlsStep::Failed
+     * @return Сообщение об ошибке
+     */
+    const std::string& error() const {
+        return message;
+    }
+
+private:
+    SSL* ssl = nullptr;     ///< Объект SSL соединения
+    std::string message;    ///< Описание ошибки
+};
@@ -0,0 +1,162 @@
+/**
+ * @file trace.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация записи и выгрузки трассы этапов сессии
+ * @details Интервалы пишутся в буфер своего потока без общей блокировки;
+ * буферы переживают завершение потоков сессий и объединяются при выгрузке.
+ * Буфер завершившегося потока передается следующему новому потоку, поэтому
+ * буферов не больше, чем одновременно живших потоков, а общее число
+ * интервалов ограничено MAX_TRACE_EVENTS
+ */
+
+#include "trace.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+std::atomic<bool> traceRecording(false);
+
+/**
+ * @brief Записанный интервал
+ */
+struct TraceEvent {
+    const char* phase;  ///< Имя этапа
+    uint64_t session;   ///< Идентификатор сессии
+    int64_t startNs;    ///< Начало от момента включения трассы (нс)
+    int64_t durNs;      ///< Длительность (нс)
+};
+
+/**
+ * @brief Буфер интервалов одного потока
+ */
+struct ThreadBuffer {
+    std::mutex mutex;               ///< Защита от выгрузки во время записи (без конкуренции)
+    std::vector<TraceEvent> events; ///< Интервалы потоков, владевших буфером
+    uint32_t thread;                ///< Порядковый номер буфера
+};
+
+static const size_t MAX_TRACE_EVENTS = 1 << 22;         ///< Ограничение памяти всех буферов
+static std::atomic<std::chrono::steady_clock::time_point> traceOrigin; ///< Момент включения трассы
+static std::atomic<uint64_t> sessionCounter(0);         ///< Счетчик идентификаторов сессий
+static std::atomic<uint64_t> recordedEvents(0);         ///< Интервалы, принятые в буферы
+static std::atomic<uint64_t> droppedEvents(0);          ///< Интервалы, не поместившиеся в буферы
+static std::mutex buffersMutex;                         ///< Защита списков буферов
+static std::vector<std::shared_ptr<ThreadBuffer>> buffers; ///< Все буферы
+static std::vector<std::shared_ptr<ThreadBuffer>> freeBuffers; ///< Буферы завершившихся потоков
+
+/**
+ * @brief Владение буфером на время жизни потока
+ * @details При завершении потока буфер вместе с интервалами остается в
+ * списке для выгрузки и передается следующему новому потоку
+ */
+struct BufferLease {
+    std::shared_ptr<ThreadBuffer> buffer;   ///< Буфер потока
+
+    BufferLease() {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        if (!freeBuffers.empty()) {
+            buffer = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        } else {
+            buffer = std::make_shared<ThreadBuffer>();
+            buffer->thread = static_cast<uint32_t>(buffers.size());
+            buffers.push_back(buffer);
+        }
+    }
+
+    ~BufferLease() {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        freeBuffers.push_back(std::move(buffer));
+    }
+};
+
+/**
+ * @brief Буфер текущего потока, получаемый при первой записи
+ * @return Буфер потока
+ */
+static ThreadBuffer& localBuffer() {
+    thread_local BufferLease lease;
+    return *lease.buffer;
+}
+
+/**
+ * @brief Включение записи интервалов
+ * @details Отсчет времени в трассе ведется от момента включения
+ */
+void traceStart() {
+    traceOrigin.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+    traceRecording.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Новый идентификатор сессии для трассы
+ * @return Уникальный в пределах процесса номер (начиная с 1)
+ */
+uint64_t traceSession() {
+    return sessionCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**
+ * @brief Сохранение интервала в буфере текущего потока
+ * @param phase Имя этапа (строковый литерал)
+ * @param session Идентификатор сессии (0 - вне сессии)
+ * @param start Начало интервала
+ * @param end Конец интервала
+ */
+void traceRecord(const char* phase, uint64_t session,
+                 std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end) {
+    if (recordedEvents.fetch_add(1, std::memory_order_relaxed) >= MAX_TRACE_EVENTS) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto origin = traceOrigin.load(std::memory_order_relaxed);
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(TraceEvent{
+        phase, session,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()});
+}
+
+/**
+ * @brief Выгрузка всех записанных интервалов в формате Chrome trace-event
+ * @param path Имя файла JSON
+ * @return Количество выгруженных интервалов или -1, если файл не открылся
+ */
+long traceExport(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        return -1;
+    }
+
+    long count = 0;
+    int pid = static_cast<int>(getpid());
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    // Имя дорожки для интервалов вне сессий (журнал и т.п.)
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"tid\":0,\"args\":{\"name\":\"server\"}}";
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const TraceEvent& e : buffer->events) {
+            // Время в trace-event задается в микросекундах
+            out << ",\n{\"name\":\"" << e.phase << "\",\"cat\":\"session\",\"ph\":\"X\",\"ts\":"
+                << e.startNs / 1000.0 << ",\"dur\":" << e.durNs / 1000.0
+                << ",\"pid\":" << pid << ",\"tid\":" << e.session
+                << ",\"args\":{\"thread\":" << buffer->thread << "}}";
+            ++count;
+        }
+    }
+
+    out << "\n],\"otherData\":{\"dropped\":" << droppedEvents.load(std::memory_order_relaxed) << "}}\n";
+    return count;
+}
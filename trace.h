@@ -0,0 +1,107 @@
+/**
+ * @file trace.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для трассировки этапов сессии
+ * @details Определяет статические точки USDT (провайдер "server") и
+ * необязательную запись интервалов этапов в буферы потоков с выгрузкой в
+ * формате Chrome trace-event JSON. Без sys/sdt.h точки USDT компилируются
+ * в пустые макросы, а при выключенной записи интервал стоит одной проверки флага
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SERVER_PROBE2(name, a, b) DTRACE_PROBE2(server, name, a, b)
+#endif
+#endif
+
+#ifndef SERVER_PROBE2
+/// Точка USDT недоступна: аргументы вычисляются, но ничего не происходит
+#define SERVER_PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#endif
+
+/// Включена ли запись интервалов
+extern std::atomic<bool> traceRecording;
+
+/**
+ * @brief Включение записи интервалов
+ * @details Отсчет времени в трассе ведется от момента включения
+ */
+void traceStart();
+
+/**
+ * @brief Новый идентификатор сессии для трассы
+ * @return Уникальный в пределах процесса номер (начиная с 1)
+ */
+uint64_t traceSession();
+
+/**
+ * @brief Сохранение интервала в буфере текущего потока
+ * @param phase Имя этапа (строковый литерал)
+ * @param session Идентификатор сессии (0 - вне сессии)
+ * @param start Начало интервала
+ * @param end Конец интервала
+ */
+void traceRecord(const char* phase, uint64_t session,
+                 std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end);
+
+/**
+ * @brief Выгрузка всех записанных интервалов в формате Chrome trace-event
+ * @param path Имя файла JSON
+ * @return Количество выгруженных интервалов или -1, если файл не открылся
+ * @details Каждая сессия отображается отдельной дорожкой (tid), интервалы
+ * вне сессий - дорожкой 0. Файл открывается в chrome://tracing и Perfetto
+ */
+long traceExport(const std::string& path);
+
+/**
+ * @class TraceSpan
+ * @brief Интервал этапа сессии на время жизни объекта
+ * @details Срабатывает точками USDT phase__start/phase__end (аргументы:
+ * имя этапа, идентификатор сессии) и, если запись включена, сохраняет
+ * интервал в буфере потока
+ */
+class TraceSpan {
+public:
+    /**
+     * @brief Начало этапа
+     * @param phase Имя этапа (строковый литерал)
+     * @param session Идентификатор сессии (0 - вне сессии)
+     */
+    TraceSpan(const char* phase, uint64_t session) : phase(phase), session(session) {
+        SERVER_PROBE2(phase__start, phase, session);
+        if (traceRecording.load(std::memory_order_relaxed)) {
+            start = std::chrono::steady_clock::now();
+            recording = true;
+        }
+    }
+
+    /**
+     * @brief Конец этапа
+     */
+    ~TraceSpan() {
+        if (recording) {
+            traceRecord(phase, session, start, std::chrono::steady_clock::now());
+        }
+        SERVER_PROBE2(phase__end, phase, session);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* phase;                              ///< Имя этапа
+    uint64_t session;                               ///< Идентификатор сессии
+    std::chrono::steady_clock::time_point start;    ///< Начало интервала
+    bool recording = false;                         ///< Записывается ли интервал
+};
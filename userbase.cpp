@@ -0,0 +1,334 @@
+/**
+ * @file userbase.cpp
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Реализация базы пользователей в разделяемой памяти
+ * @details Минимальная совершенная хеш-функция строится методом "hash and
+ * displace": логины распределяются по count корзинам первым хешем, затем
+ * корзины от больших к меньшим получают начальное значение второго хеша,
+ * при котором все их логины попадают в свободные различные ячейки.
+ * Корзины из одного логина занимают оставшиеся ячейки напрямую
+ */
+
+#include "userbase.h"
+#include "hash.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+/// Наибольшее начальное значение второго хеша перед сменой seed
+static const int32_t MAX_DISPLACEMENT = 1 << 20;
+
+/**
+ * @brief Хеш логина
+ * @param login Логин
+ * @param seed Начальное значение
+ * @return 64-битный хеш
+ */
+static inline uint64_t loginHash(std::string_view login, uint64_t seed) {
+    Hasher128 hasher(seed);
+    hasher.update(login.data(), login.size());
+    return hasher.digest().lo;
+}
+
+/**
+ * @brief Удаление пробелов и табуляций по краям строки
+ * @param s Строка
+ * @return Строка без пробельных символов по краям
+ */
+static std::string trim(const std::string& s) {
+    size_t first = s.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+/**
+ * @brief Поиск ячеек для всех логинов
+ * @param logins Логины без повторов
+ * @param seed Начальное значение хеша корзин
+ * @param displacements Смещения корзин (выходной параметр)
+ * @param slots Ячейка каждого логина (выходной параметр)
+ * @return false, если для какой-то корзины не нашлось смещения
+ */
+static bool placeLogins(const std::vector<std::string_view>& logins, uint64_t seed,
+                        std::vector<int32_t>& displacements, std::vector<uint32_t>& slots) {
+    const size_t n = logins.size();
+    std::vector<std::vector<uint32_t>> buckets(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        buckets[loginHash(logins[i], seed) % n].push_back(i);
+    }
+    std::vector<uint32_t> order(n);
+    for (uint32_t b = 0; b < n; ++b) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&buckets](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    displacements.assign(n, 0);
+    slots.assign(n, 0);
+    std::vector<bool> used(n, false);
+    std::vector<uint32_t> tried;
+    size_t next = 0;
+
+    for (; next < n && buckets[order[next]].size() > 1; ++next) {
+        const std::vector<uint32_t>& bucket = buckets[order[next]];
+        int32_t d = 1;
+        for (; d < MAX_DISPLACEMENT; ++d) {
+            tried.clear();
+            bool fits = true;
+            for (uint32_t key : bucket) {
+                uint32_t slot = static_cast<uint32_t>(loginHash(logins[key], seed + d) % n);
+                if (used[slot] || std::find(tried.begin(), tried.end(), slot) != tried.end()) {
+                    fits = false;
+                    break;
+                }
+                tried.push_back(slot);
+            }
+            if (fits) {
+                break;
+            }
+        }
+        if (d == MAX_DISPLACEMENT) {
+            return false;
+        }
+        displacements[order[next]] = d;
+        for (size_t k = 0; k < bucket.size(); ++k) {
+            used[tried[k]] = true;
+            slots[bucket[k]] = tried[k];
+        }
+    }
+
+    // Корзины из одного логина занимают свободные ячейки по порядку
+    uint32_t free_slot = 0;
+    for (; next < n && buckets[order[next]].size() == 1; ++next) {
+        while (used[free_slot]) {
+            ++free_slot;
+        }
+        used[free_slot] = true;
+        displacements[order[next]] = -static_cast<int32_t>(free_slot) - 1;
+        slots[buckets[order[next]][0]] = free_slot;
+    }
+    return true;
+}
+
+/**
+ * @brief Освобождение области памяти
+ */
+UserBase::~UserBase() {
+    if (region != nullptr) {
+        munmap(region, regionSize);
+    }
+}
+
+/**
+ * @brief Чтение текстовой базы
+ * @param path Имя файла со строками "логин:пароль"
+ * @param users Пары логин-пароль в порядке файла (выходной параметр)
+ * @return false, если файл не открылся
+ */
+bool UserBase::readText(const std::string& path, std::vector<std::pair<std::string, std::string>>& users) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    users.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+        size_t pos = line.find(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        users.emplace_back(trim(line.substr(0, pos)), trim(line.substr(pos + 1)));
+    }
+    return true;
+}
+
+/**
+ * @brief Сборка индекса
+ * @param users Пары логин-пароль; из повторяющихся логинов берется первый
+ * @return Образ индекса или пустой вектор при переполнении смещений
+ */
+std::vector<unsigned char> UserBase::compile(const std::vector<std::pair<std::string, std::string>>& users) {
+    std::vector<std::string_view> logins;
+    std::vector<const std::string*> passwords;
+    std::unordered_set<std::string_view> seen;
+    uint64_t pool_size = 0;
+    for (const auto& user : users) {
+        if (seen.insert(user.first).second) {
+            logins.push_back(user.first);
+            passwords.push_back(&user.second);
+            pool_size += user.first.size() + user.second.size();
+        }
+    }
+    if (pool_size > UINT32_MAX || logins.size() > INT32_MAX) {
+        return {};
+    }
+
+    const size_t n = logins.size();
+    std::vector<int32_t> displacements;
+    std::vector<uint32_t> slots;
+    uint64_t seed = 0;
+    while (!placeLogins(logins, seed, displacements, slots)) {
+        ++seed;
+    }
+
+    UserIndexHeader header;
+    std::memcpy(header.magic, USER_INDEX_MAGIC, sizeof(header.magic));
+    header.version = USER_INDEX_VERSION;
+    header.count = static_cast<uint32_t>(n);
+    header.seed = seed;
+    header.poolOffset = sizeof(UserIndexHeader) + n * (sizeof(int32_t) + sizeof(UserRecord));
+    header.size = header.poolOffset + pool_size;
+
+    std::vector<unsigned char> image(header.size);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(header), displacements.data(), n * sizeof(int32_t));
+    UserRecord* cells = reinterpret_cast<UserRecord*>(image.data() + sizeof(header) + n * sizeof(int32_t));
+    char* strings = reinterpret_cast<char*>(image.data() + header.poolOffset);
+    uint32_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const std::string& password = *passwords[i];
+        cells[slots[i]] = UserRecord{offset, static_cast<uint32_t>(logins[i].size()),
+                                     static_cast<uint32_t>(offset + logins[i].size()), static_cast<uint32_t>(password.size())};
+        std::memcpy(strings + offset, logins[i].data(), logins[i].size());
+        std::memcpy(strings + offset + logins[i].size(), password.data(), password.size());
+        offset += static_cast<uint32_t>(logins[i].size() + password.size());
+    }
+    return image;
+}
+
+/**
+ * @brief Проверка заголовка и подключение индекса
+ * @param mem Область индекса
+ * @param size Размер области
+ * @return false, если заголовок не соответствует области
+ */
+bool UserBase::attach(void* mem, size_t size) {
+    if (size < sizeof(UserIndexHeader)) {
+        return false;
+    }
+    const UserIndexHeader* h = static_cast<const UserIndexHeader*>(mem);
+    uint64_t tables = sizeof(UserIndexHeader) + static_cast<uint64_t>(h->count) * (sizeof(int32_t) + sizeof(UserRecord));
+    if (std::memcmp(h->magic, USER_INDEX_MAGIC, sizeof(h->magic)) != 0 || h->version != USER_INDEX_VERSION
+        || h->size != size || h->poolOffset != tables || h->poolOffset > size) {
+        return false;
+    }
+    const unsigned char* base = static_cast<const unsigned char*>(mem);
+    header = h;
+    displacements = reinterpret_cast<const int32_t*>(base + sizeof(UserIndexHeader));
+    records = reinterpret_cast<const UserRecord*>(base + sizeof(UserIndexHeader) + h->count * sizeof(int32_t));
+    pool = reinterpret_cast<const char*>(base + h->poolOffset);
+    poolSize = size - h->poolOffset;
+    return true;
+}
+
+/**
+ * @brief Загрузка базы из файла индекса или текстового файла
+ * @param path Имя файла: индекс basec или строки "логин:пароль"
+ * @return false, если файл не открылся, индекс поврежден или не удалось
+ * выделить память
+ */
+bool UserBase::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    char magic[8] = {};
+    bool indexed = fstat(fd, &st) == 0 && pread(fd, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic))
+                   && std::memcmp(magic, USER_INDEX_MAGIC, sizeof(magic)) == 0;
+
+    void* mem = MAP_FAILED;
+    size_t size = 0;
+    if (indexed) {
+        // Страницы индекса берутся из кэша файла и общие для всех процессов
+        size = static_cast<size_t>(st.st_size);
+        mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+    } else {
+        close(fd);
+        std::vector<std::pair<std::string, std::string>> users;
+        if (!readText(path, users)) {
+            return false;
+        }
+        std::vector<unsigned char> image = compile(users);
+        if (image.empty()) {
+            return false;
+        }
+        size = image.size();
+        mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem != MAP_FAILED) {
+            std::memcpy(mem, image.data(), size);
+            // Дальнейшие изменения невозможны; порожденные процессы делят те же страницы
+            mprotect(mem, size, PROT_READ);
+        }
+    }
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    void* old_region = region;
+    size_t old_size = regionSize;
+    if (!attach(mem, size)) {
+        munmap(mem, size);
+        if (old_region != nullptr) {
+            attach(old_region, old_size);
+        }
+        return false;
+    }
+    if (old_region != nullptr) {
+        munmap(old_region, old_size);
+    }
+    region = mem;
+    regionSize = size;
+    fromFile = indexed;
+    return true;
+}
+
+/**
+ * @brief Поиск пароля по логину
+ * @param login Логин
+ * @param password Найденный пароль (выходной параметр)
+ * @return true, если пользователь найден
+ */
+bool UserBase::find(const std::string& login, std::string& password) const {
+    if (header == nullptr || header->count == 0) {
+        return false;
+    }
+    const uint32_t n = header->count;
+    int32_t d = displacements[loginHash(login, header->seed) % n];
+    uint64_t slot = d < 0 ? static_cast<uint64_t>(-static_cast<int64_t>(d) - 1)
+                          : loginHash(login, header->seed + static_cast<uint64_t>(d)) % n;
+    if (slot >= n) {
+        return false;
+    }
+    const UserRecord& r = records[slot];
+    if (static_cast<uint64_t>(r.loginOffset) + r.loginLength > poolSize
+        || static_cast<uint64_t>(r.passwordOffset) + r.passwordLength > poolSize
+        || std::string_view(pool + r.loginOffset, r.loginLength) != login) {
+        return false;
+    }
+    password.assign(pool + r.passwordOffset, r.passwordLength);
+    return true;
+}
+
+/**
+ * @brief Количество пользователей
+ * @return Количество записей базы
+ */
+size_t UserBase::size() const {
+    return header != nullptr ? header->count : 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file userbase.h
+ * @author Мураев Н.Д.
+ * @version 1.0
+ * @date 2025
+ * @copyright ИБСТ ПГУ
+ * @brief Заголовочный файл для базы пользователей в разделяемой памяти
+ * @details База хранится в виде индекса с минимальной совершенной
+ * хеш-функцией по логинам. Индекс либо заранее собирается инструментом
+ * basec и отображается в память из файла, либо собирается при загрузке
+ * текстовой базы в анонимную разделяемую область. В обоих случаях память
+ * доступна только для чтения, и рабочие процессы, порожденные после
+ * загрузки, используют те же страницы.
+ *
+ * Формат индекса (порядок байтов машины):
+ * - заголовок UserIndexHeader;
+ * - смещения корзин (int32_t, count штук): d >= 0 - начальное значение
+ *   второго хеша, d < 0 - номер ячейки -d-1 для корзины из одного логина;
+ * - ячейки UserRecord (count штук);
+ * - пул строк логинов и паролей
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define USER_INDEX_MAGIC "SRVUIDX\n"    ///< Заголовок файла индекса (8 байт)
+#define USER_INDEX_VERSION 1            ///< Версия формата индекса
+
+/**
+ * @struct UserIndexHeader
+ * @brief Заголовок индекса базы пользователей
+ */
+struct UserIndexHeader {
+    char magic[8];          ///< USER_INDEX_MAGIC
+    uint32_t version;       ///< USER_INDEX_VERSION
+    uint32_t count;         ///< Количество пользователей, корзин и ячеек
+    uint64_t seed;          ///< Начальное значение хеша корзин
+    uint64_t poolOffset;    ///< Смещение пула строк от начала индекса
+    uint64_t size;          ///< Полный размер индекса
+};
+
+/**
+ * @struct UserRecord
+ * @brief Ячейка индекса
+ */
+struct UserRecord {
+    uint32_t loginOffset;       ///< Смещение логина в пуле строк
+    uint32_t loginLength;       ///< Длина логина
+    uint32_t passwordOffset;    ///< Смещение пароля в пуле строк
+    uint32_t passwordLength;    ///< Длина пароля
+};
+
+/**
+ * @class UserBase
+ * @brief Неизменяемая база пользователей с поиском по логину
+ * @details Поиск вычисляет два хеша логина и сравнивает логин в
+ * единственной подходящей ячейке; время поиска и загрузки индекса из файла
+ * не зависит от размера базы. При повторяющихся логинах используется
+ * первый в текстовой базе
+ */
+class UserBase {
+public:
+    UserBase() = default;
+
+    /**
+     * @brief Освобождение области памяти
+     */
+    ~UserBase();
+
+    UserBase(const UserBase&) = delete;
+    UserBase& operator=(const UserBase&) = delete;
+
+    /**
+     * @brief Загрузка базы из файла индекса или текстового файла
+     * @param path Имя файла: индекс basec или строки "логин:пароль"
+     * @return false, если файл не открылся, индекс поврежден или не удалось
+     * выделить память
+     * @details Формат определяется по заголовку файла. Индекс отображается в
+     * память без чтения и проверяется только по заголовку; границы строк
+     * проверяются при поиске
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Поиск пароля по логину
+     * @param login Логин
+     * @param password Найденный пароль (выходной параметр)
+     * @return true, если пользователь найден
+     */
+    bool find(const std::string& login, std::string& password) const;
+
+    /**
+     * @brief Количество пользователей
+     * @return Количество записей базы
+     */
+    size_t size() const;
+
+    /**
+     * @brief Загружена ли база из готового индекса
+     * @return true для индекса basec, false для текстовой базы
+     */
+    bool compiled() const {
+        return fromFile;
+    }
+
+    /**
+     * @brief Чтение текстовой базы
+     * @param path Имя файла со строками "логин:пароль"
+     * @param users Пары логин-пароль в порядке файла (выходной параметр)
+     * @return false, если файл не открылся
+     * @details Пустые строки и строки, начинающиеся с '#' или ';', а также
+     * строки без ':' пропускаются; пробелы и табуляции по краям логина и
+     * пароля отбрасываются
+     */
+    static bool readText(const std::string& path, std::vector<std::pair<std::string, std::string>>& users);
+
+    /**
+     * @brief Сборка индекса
+     * @param users Пары логин-пароль; из повторяющихся логинов берется первый
+     * @return Образ индекса или пустой вектор, если строки не помещаются в
+     * 32-битные смещения
+     */
+    static std::vector<unsigned char> compile(const std::vector<std::pair<std::string, std::string>>& users);
+
+private:
+    /**
+     * @brief Проверка заголовка и подключение индекса
+     * @param mem Область индекса
+     * @param size Размер области
+     * @return false, если заголовок не соответствует области
+     */
+    bool attach(void* mem, size_t size);
+
+    void* region = nullptr;                 ///< Область памяти базы
+    size_t regionSize = 0;                  ///< Размер области
+    bool fromFile = false;                  ///< Область отображена из файла индекса
+    const UserIndexHeader* header = nullptr; ///< Заголовок индекса
+    const int32_t* displacements = nullptr; ///< Смещения корзин
+    const UserRecord* records = nullptr;    ///< Ячейки
+    const char* pool = nullptr;             ///< Пул строк
+    uint64_t poolSize = 0;                  ///< Размер пула строк
+};